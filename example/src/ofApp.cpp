@@ -13,13 +13,20 @@ void ofApp::setup()
         device->enableDepth();
         device->enableColor();
         device->enablePoints();
-        device->startPipeline();
+    }));
+
+    this->eventListeners.push(this->context.deviceReadyEvent.newListener([&](std::string serialNumber)
+    {
+        ofLogNotice(__FUNCTION__) << "Device " << serialNumber << " ready";
+        auto device = this->context.getDevice(serialNumber);
         this->guiPanel.add(device->params);
     }));
 
     try
     {
+        // Devices start in the background, the app keeps running in the meantime.
         this->context.setup(false);
+        this->context.startDevices();
     }
     catch (std::exception& e)
     {
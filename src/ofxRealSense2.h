@@ -1,4 +1,14 @@
 #pragma once
 
+#include "ofxRealSense2/BackgroundModel.h"
+#include "ofxRealSense2/BlobFinder.h"
+#include "ofxRealSense2/ClipVolume.h"
 #include "ofxRealSense2/Context.h"
-#include "ofxRealSense2/Device.h"
\ No newline at end of file
+#include "ofxRealSense2/DepthRenderer.h"
+#include "ofxRealSense2/Device.h"
+#include "ofxRealSense2/IcpOdometry.h"
+#include "ofxRealSense2/Intrinsics.h"
+#include "ofxRealSense2/OccupancyGrid.h"
+#include "ofxRealSense2/PlaneDetector.h"
+#include "ofxRealSense2/RegionStats.h"
+#include "ofxRealSense2/TsdfVolume.h"
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "BackgroundModel.h"
+
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ofxRealSense2
+{
+    BackgroundModel::BackgroundModel()
+        : width(0)
+        , height(0)
+        , numFrames(0)
+        , frozen(false)
+        , relearnPending(false)
+        , learningRate(0.01f)
+        , threshold(0.05f)
+        , deviations(3.0f)
+    {
+
+    }
+
+    void BackgroundModel::update(const uint16_t * depthData, int width, int height, float depthScale, uint8_t * maskData)
+    {
+        if (this->width != width || this->height != height || this->relearnPending.exchange(false))
+        {
+            this->reset(width, height);
+        }
+
+        const bool learn = !this->frozen;
+
+        // Pixels without any background sample only count as foreground once something was learned.
+        const bool emptyIsForeground = this->numFrames > 0;
+
+        const size_t numPixels = size_t(width) * height;
+        float * meanData = this->mean.data();
+        float * varianceData = this->variance.data();
+        float * countData = this->count.data();
+
+        size_t i = 0;
+
+#ifdef OFX_REALSENSE2_SSE2
+        const __m128 scale4 = _mm_set1_ps(depthScale);
+        const __m128 rate4 = _mm_set1_ps(this->learningRate);
+        const __m128 threshold4 = _mm_set1_ps(this->threshold);
+        const __m128 deviations4 = _mm_set1_ps(this->deviations);
+        const __m128 empty4 = _mm_castsi128_ps(_mm_set1_epi32(emptyIsForeground ? -1 : 0));
+        const __m128 zero4 = _mm_setzero_ps();
+        const __m128 one4 = _mm_set1_ps(1.0f);
+        const __m128i zeroi = _mm_setzero_si128();
+
+        for (; i + 8 <= numPixels; i += 8)
+        {
+            const __m128i raw8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(depthData + i));
+            __m128i mask4[2];
+
+            for (int h = 0; h < 2; ++h)
+            {
+                const size_t j = i + h * 4;
+                const __m128i raw4 = h == 0 ? _mm_unpacklo_epi16(raw8, zeroi) : _mm_unpackhi_epi16(raw8, zeroi);
+                const __m128 x = _mm_mul_ps(_mm_cvtepi32_ps(raw4), scale4);
+                const __m128 valid = _mm_cmpgt_ps(x, zero4);
+
+                __m128 n = _mm_loadu_ps(countData + j);
+                __m128 m = _mm_loadu_ps(meanData + j);
+                __m128 v = _mm_loadu_ps(varianceData + j);
+
+                // Classify against the model before learning the new sample.
+                const __m128 limit = _mm_max_ps(_mm_mul_ps(deviations4, _mm_sqrt_ps(v)), threshold4);
+                const __m128 closer = _mm_cmpgt_ps(_mm_sub_ps(m, x), limit);
+                const __m128 empty = _mm_and_ps(_mm_cmpeq_ps(n, zero4), empty4);
+                mask4[h] = _mm_castps_si128(_mm_and_ps(valid, _mm_or_ps(closer, empty)));
+
+                if (learn)
+                {
+                    n = _mm_add_ps(n, _mm_and_ps(valid, one4));
+                    const __m128 alpha = _mm_and_ps(valid, _mm_max_ps(_mm_div_ps(one4, n), rate4));
+                    const __m128 delta = _mm_sub_ps(x, m);
+                    m = _mm_add_ps(m, _mm_mul_ps(alpha, delta));
+                    v = _mm_mul_ps(_mm_sub_ps(one4, alpha), _mm_add_ps(v, _mm_mul_ps(alpha, _mm_mul_ps(delta, delta))));
+
+                    _mm_storeu_ps(countData + j, n);
+                    _mm_storeu_ps(meanData + j, m);
+                    _mm_storeu_ps(varianceData + j, v);
+                }
+            }
+
+            // All-ones lanes saturate to 0xFF bytes.
+            const __m128i mask8 = _mm_packs_epi16(_mm_packs_epi32(mask4[0], mask4[1]), zeroi);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(maskData + i), mask8);
+        }
+#endif
+
+        for (; i < numPixels; ++i)
+        {
+            const float x = depthData[i] * depthScale;
+            const bool valid = depthData[i] > 0;
+
+            float n = countData[i];
+            float m = meanData[i];
+            float v = varianceData[i];
+
+            const float limit = std::max(this->deviations * std::sqrt(v), this->threshold);
+            const bool foreground = valid && ((m - x) > limit || (n == 0.0f && emptyIsForeground));
+            maskData[i] = foreground ? 255 : 0;
+
+            if (learn && valid)
+            {
+                n += 1.0f;
+                const float alpha = std::max(1.0f / n, this->learningRate);
+                const float delta = x - m;
+                m += alpha * delta;
+                v = (1.0f - alpha) * (v + alpha * delta * delta);
+
+                countData[i] = n;
+                meanData[i] = m;
+                varianceData[i] = v;
+            }
+        }
+
+        if (learn)
+        {
+            ++this->numFrames;
+        }
+    }
+
+    void BackgroundModel::relearn()
+    {
+        this->relearnPending = true;
+    }
+
+    void BackgroundModel::setFrozen(bool frozen)
+    {
+        this->frozen = frozen;
+    }
+
+    bool BackgroundModel::isFrozen() const
+    {
+        return this->frozen;
+    }
+
+    void BackgroundModel::setLearningRate(float learningRate)
+    {
+        this->learningRate = learningRate;
+    }
+
+    void BackgroundModel::setThreshold(float threshold)
+    {
+        this->threshold = threshold;
+    }
+
+    void BackgroundModel::setDeviations(float deviations)
+    {
+        this->deviations = deviations;
+    }
+
+    int BackgroundModel::getWidth() const
+    {
+        return this->width;
+    }
+
+    int BackgroundModel::getHeight() const
+    {
+        return this->height;
+    }
+
+    const std::vector<float> & BackgroundModel::getMean() const
+    {
+        return this->mean;
+    }
+
+    const std::vector<float> & BackgroundModel::getVariance() const
+    {
+        return this->variance;
+    }
+
+    void BackgroundModel::reset(int width, int height)
+    {
+        this->width = width;
+        this->height = height;
+
+        const size_t numPixels = size_t(width) * height;
+        this->mean.assign(numPixels, 0.0f);
+        this->variance.assign(numPixels, 0.0f);
+        this->count.assign(numPixels, 0.0f);
+        this->numFrames = 0;
+    }
+}
\ No newline at end of file
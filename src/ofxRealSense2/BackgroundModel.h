@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace ofxRealSense2
+{
+    // Per-pixel running mean and variance of depth (in meters), used to segment
+    // foreground from raw Z16 depth. Samples are blended with a weight of
+    // max(1 / count, learningRate), which is a plain Welford average until the
+    // learning rate takes over. Zero depth is treated as missing and never learned.
+    class BackgroundModel
+    {
+    public:
+        BackgroundModel();
+
+        // Classifies the depth data into the mask (255 for foreground, 0 otherwise),
+        // then learns it unless the model is frozen. Resets when the size changes.
+        void update(const uint16_t * depthData, int width, int height, float depthScale, uint8_t * maskData);
+
+        void relearn();
+
+        void setFrozen(bool frozen);
+        bool isFrozen() const;
+
+        void setLearningRate(float learningRate);
+        void setThreshold(float threshold);
+        void setDeviations(float deviations);
+
+        int getWidth() const;
+        int getHeight() const;
+
+        const std::vector<float> & getMean() const;
+        const std::vector<float> & getVariance() const;
+
+    private:
+        void reset(int width, int height);
+
+    private:
+        int width;
+        int height;
+
+        std::vector<float> mean;
+        std::vector<float> variance;
+        std::vector<float> count;
+        int numFrames;
+
+        std::atomic<bool> frozen;
+        std::atomic<bool> relearnPending;
+
+        float learningRate;
+        float threshold;
+        float deviations;
+    };
+}
\ No newline at end of file
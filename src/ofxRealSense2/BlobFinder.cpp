@@ -0,0 +1,321 @@
+#include "BlobFinder.h"
+
+#include "Simd.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace ofxRealSense2
+{
+    BlobFinder::BlobFinder()
+        : minArea(100)
+        , maxBlobs(16)
+    {
+
+    }
+
+    void BlobFinder::threshold(const uint16_t * depthData, size_t numPixels, uint16_t minDepth, uint16_t maxDepth, uint8_t * maskData)
+    {
+        // Zero depth is missing data, never part of a blob.
+        minDepth = std::max<uint16_t>(minDepth, 1);
+
+        size_t i = 0;
+
+#ifdef OFX_REALSENSE2_SSE2
+        // SSE2 has no unsigned 16-bit compare, saturated subtraction is zero when in range.
+        const __m128i min8 = _mm_set1_epi16((short)minDepth);
+        const __m128i max8 = _mm_set1_epi16((short)maxDepth);
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 16 <= numPixels; i += 16)
+        {
+            const __m128i depthA = _mm_loadu_si128(reinterpret_cast<const __m128i *>(depthData + i));
+            const __m128i depthB = _mm_loadu_si128(reinterpret_cast<const __m128i *>(depthData + i + 8));
+            const __m128i inA = _mm_cmpeq_epi16(_mm_or_si128(_mm_subs_epu16(min8, depthA), _mm_subs_epu16(depthA, max8)), zero);
+            const __m128i inB = _mm_cmpeq_epi16(_mm_or_si128(_mm_subs_epu16(min8, depthB), _mm_subs_epu16(depthB, max8)), zero);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(maskData + i), _mm_packs_epi16(inA, inB));
+        }
+#endif
+
+        for (; i < numPixels; ++i)
+        {
+            maskData[i] = (depthData[i] >= minDepth && depthData[i] <= maxDepth) ? 255 : 0;
+        }
+    }
+
+    void BlobFinder::find(const uint8_t * maskData, const uint16_t * depthData, int width, int height, float depthScale, std::vector<Blob> & blobs)
+    {
+        blobs.clear();
+
+        const size_t numPixels = size_t(width) * height;
+        if (numPixels == 0) return;
+
+        this->labels.resize(numPixels);
+        this->parents.resize(numPixels + 1);
+        this->roots.resize(numPixels + 1);
+        this->blobIds.resize(numPixels + 1);
+        this->localIds.resize(numPixels + 1);
+
+        auto & pool = ThreadPool::getShared();
+        const int numStrips = std::max(1, std::min(pool.getConcurrency(), height / 16));
+        this->stripRows.resize(numStrips + 1);
+        for (int s = 0; s <= numStrips; ++s)
+        {
+            this->stripRows[s] = height * s / numStrips;
+        }
+        this->stripBlobs.resize(numStrips + 1);
+        this->stripLabels.resize(numStrips);
+        this->stripStats.resize(numStrips);
+
+        // A pixel only creates a label when none of its earlier neighbours are set, so at most
+        // every other pixel of every other row does. Reserving that keeps find() from allocating.
+        size_t maxLabels = 0;
+        for (int s = 0; s < numStrips; ++s)
+        {
+            const size_t maxStripLabels = size_t((width + 1) / 2) * ((this->stripRows[s + 1] - this->stripRows[s] + 1) / 2);
+            this->stripLabels[s].reserve(maxStripLabels);
+            this->stripStats[s].reserve(maxStripLabels);
+            maxLabels += maxStripLabels;
+        }
+        this->blobStats.reserve(maxLabels);
+        blobs.reserve(this->maxBlobs);
+
+        int * labelData = this->labels.data();
+        int * parentData = this->parents.data();
+
+        // First pass, provisional labels per strip. Strips only touch their own labels.
+        pool.parallelFor(numStrips, [&](int s)
+        {
+            const int y0 = this->stripRows[s];
+            const int y1 = this->stripRows[s + 1];
+            for (int y = y0; y < y1; ++y)
+            {
+                const int row = y * width;
+                for (int x = 0; x < width; ++x)
+                {
+                    const int idx = row + x;
+                    if (!maskData[idx])
+                    {
+                        labelData[idx] = 0;
+                        continue;
+                    }
+
+                    int label = x > 0 ? labelData[idx - 1] : 0;
+                    if (y > y0)
+                    {
+                        const int above = idx - width;
+                        for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, width - 1); ++nx)
+                        {
+                            const int neighbor = labelData[above - x + nx];
+                            if (!neighbor) continue;
+
+                            if (!label)
+                            {
+                                label = neighbor;
+                            }
+                            else if (neighbor != label)
+                            {
+                                this->unite(label, neighbor);
+                            }
+                        }
+                    }
+
+                    if (!label)
+                    {
+                        label = idx + 1;
+                        parentData[label] = label;
+                    }
+                    labelData[idx] = label;
+                }
+            }
+        });
+
+        // Merge labels across the strip seams.
+        for (int s = 1; s < numStrips; ++s)
+        {
+            const int row = this->stripRows[s] * width;
+            for (int x = 0; x < width; ++x)
+            {
+                const int label = labelData[row + x];
+                if (!label) continue;
+
+                for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, width - 1); ++nx)
+                {
+                    const int neighbor = labelData[row - width + nx];
+                    if (neighbor)
+                    {
+                        this->unite(label, neighbor);
+                    }
+                }
+            }
+        }
+
+        // Resolve the roots of the labels created in each strip and count the blobs.
+        int * rootData = this->roots.data();
+        int * localIdData = this->localIds.data();
+        pool.parallelFor(numStrips, [&](int s)
+        {
+            auto & stripLabels = this->stripLabels[s];
+            stripLabels.clear();
+
+            int numBlobs = 0;
+            const int idx0 = this->stripRows[s] * width;
+            const int idx1 = this->stripRows[s + 1] * width;
+            for (int idx = idx0; idx < idx1; ++idx)
+            {
+                const int label = labelData[idx];
+                if (label != idx + 1) continue;
+
+                localIdData[label] = (int)stripLabels.size();
+                stripLabels.push_back(label);
+                rootData[label] = this->findRoot(label);
+                if (rootData[label] == label)
+                {
+                    ++numBlobs;
+                }
+            }
+            this->stripBlobs[s + 1] = numBlobs;
+        });
+
+        this->stripBlobs[0] = 0;
+        for (int s = 0; s < numStrips; ++s)
+        {
+            this->stripBlobs[s + 1] += this->stripBlobs[s];
+        }
+        const int totalBlobs = this->stripBlobs[numStrips];
+        if (totalBlobs == 0) return;
+
+        // Number the blobs, then gather their statistics per strip.
+        int * blobIdData = this->blobIds.data();
+        pool.parallelFor(numStrips, [&](int s)
+        {
+            int blobId = this->stripBlobs[s];
+            const int idx0 = this->stripRows[s] * width;
+            const int idx1 = this->stripRows[s + 1] * width;
+            for (int idx = idx0; idx < idx1; ++idx)
+            {
+                const int label = labelData[idx];
+                if (label == idx + 1 && rootData[label] == label)
+                {
+                    blobIdData[label] = blobId++;
+                }
+            }
+        });
+
+        // Strips only hold the labels they created, so this stays proportional to the
+        // strip size however many blobs the whole mask has.
+        const Stats empty = { 0, 0, 0, width, height, -1, -1, 0, 0 };
+        pool.parallelFor(numStrips, [&](int s)
+        {
+            auto & stats = this->stripStats[s];
+            stats.assign(this->stripLabels[s].size(), empty);
+
+            for (int y = this->stripRows[s]; y < this->stripRows[s + 1]; ++y)
+            {
+                const int row = y * width;
+                for (int x = 0; x < width; ++x)
+                {
+                    const int label = labelData[row + x];
+                    if (!label) continue;
+
+                    auto & blob = stats[localIdData[label]];
+                    ++blob.count;
+                    blob.sumX += x;
+                    blob.sumY += y;
+                    blob.minX = std::min(blob.minX, x);
+                    blob.minY = std::min(blob.minY, y);
+                    blob.maxX = std::max(blob.maxX, x);
+                    blob.maxY = std::max(blob.maxY, y);
+                    if (depthData && depthData[row + x])
+                    {
+                        ++blob.depthCount;
+                        blob.depthSum += depthData[row + x];
+                    }
+                }
+            }
+        });
+
+        // Reduce the label statistics into their blobs.
+        this->blobStats.assign(totalBlobs, empty);
+        for (int s = 0; s < numStrips; ++s)
+        {
+            const auto & stripLabels = this->stripLabels[s];
+            const auto & stripStats = this->stripStats[s];
+            for (size_t i = 0; i < stripLabels.size(); ++i)
+            {
+                const auto & stats = stripStats[i];
+                auto & total = this->blobStats[blobIdData[rootData[stripLabels[i]]]];
+                total.count += stats.count;
+                total.sumX += stats.sumX;
+                total.sumY += stats.sumY;
+                total.minX = std::min(total.minX, stats.minX);
+                total.minY = std::min(total.minY, stats.minY);
+                total.maxX = std::max(total.maxX, stats.maxX);
+                total.maxY = std::max(total.maxY, stats.maxY);
+                total.depthCount += stats.depthCount;
+                total.depthSum += stats.depthSum;
+            }
+        }
+
+        // Keep the largest blobs in a min-heap, so the list never grows past the maximum.
+        const auto largerArea = [](const Blob & a, const Blob & b)
+        {
+            return a.area > b.area;
+        };
+        for (const auto & total : this->blobStats)
+        {
+            if (total.count < this->minArea) continue;
+            if (blobs.size() == size_t(this->maxBlobs))
+            {
+                if (this->maxBlobs == 0 || total.count <= blobs.front().area) continue;
+
+                std::pop_heap(blobs.begin(), blobs.end(), largerArea);
+                blobs.pop_back();
+            }
+
+            Blob blob;
+            blob.area = total.count;
+            blob.centroid = glm::vec2(total.sumX / (float)total.count, total.sumY / (float)total.count);
+            blob.boundingBox.set(total.minX, total.minY, total.maxX - total.minX + 1, total.maxY - total.minY + 1);
+            blob.meanDepth = total.depthCount ? (total.depthSum * depthScale / total.depthCount) : 0.0f;
+            blobs.push_back(blob);
+            std::push_heap(blobs.begin(), blobs.end(), largerArea);
+        }
+
+        std::sort_heap(blobs.begin(), blobs.end(), largerArea);
+    }
+
+    void BlobFinder::setMinArea(int minArea)
+    {
+        this->minArea = minArea;
+    }
+
+    void BlobFinder::setMaxBlobs(int maxBlobs)
+    {
+        this->maxBlobs = std::max(maxBlobs, 0);
+    }
+
+    int BlobFinder::findRoot(int label) const
+    {
+        while (this->parents[label] != label)
+        {
+            label = this->parents[label];
+        }
+        return label;
+    }
+
+    void BlobFinder::unite(int labelA, int labelB)
+    {
+        // The smallest label stays the root, so roots always come first in scan order.
+        const int rootA = this->findRoot(labelA);
+        const int rootB = this->findRoot(labelB);
+        if (rootA < rootB)
+        {
+            this->parents[rootB] = rootA;
+        }
+        else if (rootB < rootA)
+        {
+            this->parents[rootA] = rootB;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ofRectangle.h"
+#include "ofVectorMath.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace ofxRealSense2
+{
+    struct Blob
+    {
+        // Size in pixels.
+        int area;
+        // Pixel coordinates.
+        glm::vec2 centroid;
+        ofRectangle boundingBox;
+        // Meters, averaged over the blob pixels with valid depth.
+        float meanDepth;
+    };
+
+    // Connected components (8-way) of a binary mask, labelled with a two-pass
+    // union-find. The image is split in horizontal strips that are labelled in
+    // parallel, then the strip seams are merged. Statistics are gathered per
+    // strip for the labels it created, and reduced into blobs through their roots.
+    class BlobFinder
+    {
+    public:
+        BlobFinder();
+
+        // Sets the mask to 255 where raw depth is within [minDepth, maxDepth], 0 otherwise.
+        static void threshold(const uint16_t * depthData, size_t numPixels, uint16_t minDepth, uint16_t maxDepth, uint8_t * maskData);
+
+        // Finds the blobs in the mask, largest first. The depth data is optional.
+        void find(const uint8_t * maskData, const uint16_t * depthData, int width, int height, float depthScale, std::vector<Blob> & blobs);
+
+        void setMinArea(int minArea);
+        void setMaxBlobs(int maxBlobs);
+
+    private:
+        struct Stats
+        {
+            int count;
+            int64_t sumX;
+            int64_t sumY;
+            int minX;
+            int minY;
+            int maxX;
+            int maxY;
+            int depthCount;
+            int64_t depthSum;
+        };
+
+        int findRoot(int label) const;
+        void unite(int labelA, int labelB);
+
+    private:
+        int minArea;
+        int maxBlobs;
+
+        // Indexed by pixel.
+        std::vector<int> labels;
+        // Indexed by label, which is the index + 1 of the pixel that created it.
+        std::vector<int> parents;
+        std::vector<int> roots;
+        std::vector<int> blobIds;
+        // Index of the label among the ones created in its strip.
+        std::vector<int> localIds;
+
+        std::vector<int> stripRows;
+        std::vector<int> stripBlobs;
+        // Labels created in each strip and their statistics, in creation order.
+        std::vector<std::vector<int>> stripLabels;
+        std::vector<std::vector<Stats>> stripStats;
+        std::vector<Stats> blobStats;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include "ClipVolume.h"
+
+namespace ofxRealSense2
+{
+    ClipVolume::ClipVolume()
+    {
+
+    }
+
+    void ClipVolume::setBox(const glm::vec3 & center, const glm::vec3 & size, const glm::quat & orientation)
+    {
+        this->planes.clear();
+
+        // Two opposing planes per box axis.
+        const auto axes = glm::mat3_cast(orientation);
+        const auto halfSize = size * 0.5f;
+        for (int i = 0; i < 3; ++i)
+        {
+            const auto axis = glm::normalize(axes[i]);
+            const float offset = glm::dot(axis, center);
+            this->addPlane(-axis, halfSize[i] + offset);
+            this->addPlane(axis, halfSize[i] - offset);
+        }
+    }
+
+    void ClipVolume::addPlane(const glm::vec3 & normal, float distance)
+    {
+        this->planes.emplace_back(normal, distance);
+    }
+
+    void ClipVolume::clear()
+    {
+        this->planes.clear();
+    }
+
+    bool ClipVolume::isEmpty() const
+    {
+        return this->planes.empty();
+    }
+
+    bool ClipVolume::contains(const glm::vec3 & point) const
+    {
+        for (const auto & plane : this->planes)
+        {
+            if (plane.x * point.x + plane.y * point.y + plane.z * point.z + plane.w < 0.0f)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const std::vector<glm::vec4> & ClipVolume::getPlanes() const
+    {
+        return this->planes;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "ofVectorMath.h"
+
+#include <vector>
+
+namespace ofxRealSense2
+{
+    // Convex volume in depth camera space (meters), stored as a set of planes.
+    // A point is inside when dot(plane.xyz, point) + plane.w >= 0 for every plane.
+    // An empty volume contains everything.
+    class ClipVolume
+    {
+    public:
+        ClipVolume();
+
+        void setBox(const glm::vec3 & center, const glm::vec3 & size, const glm::quat & orientation = glm::quat());
+        void addPlane(const glm::vec3 & normal, float distance);
+        void clear();
+
+        bool isEmpty() const;
+        bool contains(const glm::vec3 & point) const;
+
+        const std::vector<glm::vec4> & getPlanes() const;
+
+    private:
+        std::vector<glm::vec4> planes;
+    };
+}
\ No newline at end of file
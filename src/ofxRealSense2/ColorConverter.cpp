@@ -0,0 +1,196 @@
+#include "ColorConverter.h"
+
+#include "Simd.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace ofxRealSense2
+{
+    namespace
+    {
+        inline uint8_t clampByte(int value)
+        {
+            return (uint8_t)std::min(std::max(value, 0), 255);
+        }
+
+        template<bool Uyvy>
+        void convertScalar(const uint8_t * srcData, size_t numPixels, uint8_t * dstData, ofPixelFormat dstFormat)
+        {
+            const int numChannels = (dstFormat == OF_PIXELS_RGB) ? 3 : 4;
+            const bool bgr = (dstFormat == OF_PIXELS_BGRA);
+            for (size_t i = 0; i < numPixels; i += 2)
+            {
+                const uint8_t * src = srcData + i * 2;
+                const int y[2] = { (Uyvy ? src[1] : src[0]) - 16, (Uyvy ? src[3] : src[2]) - 16 };
+                const int d = (Uyvy ? src[0] : src[1]) - 128;
+                const int e = (Uyvy ? src[2] : src[3]) - 128;
+
+                for (int j = 0; j < 2; ++j)
+                {
+                    uint8_t * dst = dstData + (i + j) * numChannels;
+                    const uint8_t r = clampByte((298 * y[j] + 409 * e + 128) >> 8);
+                    const uint8_t g = clampByte((298 * y[j] - 100 * d - 208 * e + 128) >> 8);
+                    const uint8_t b = clampByte((298 * y[j] + 516 * d + 128) >> 8);
+                    dst[0] = bgr ? b : r;
+                    dst[1] = g;
+                    dst[2] = bgr ? r : b;
+                    if (numChannels == 4)
+                    {
+                        dst[3] = 255;
+                    }
+                }
+            }
+        }
+
+#ifdef OFX_REALSENSE2_SSE2
+        // Converts 4 pixels, unpacked to 16 bits, into 32-bit R, G and B values.
+        // The luma is paired with the shared chroma of each pixel so madd can do
+        // the multiply-adds in 32 bits.
+        template<bool Uyvy>
+        inline void convert4(__m128i yuv, __m128i & r, __m128i & g, __m128i & b)
+        {
+            __m128i ce;
+            __m128i cd;
+            if (Uyvy)
+            {
+                yuv = _mm_sub_epi16(yuv, _mm_setr_epi16(128, 16, 128, 16, 128, 16, 128, 16));
+                ce = _mm_shufflehi_epi16(_mm_shufflelo_epi16(yuv, _MM_SHUFFLE(2, 3, 2, 1)), _MM_SHUFFLE(2, 3, 2, 1));
+                cd = _mm_shufflehi_epi16(_mm_shufflelo_epi16(yuv, _MM_SHUFFLE(0, 3, 0, 1)), _MM_SHUFFLE(0, 3, 0, 1));
+            }
+            else
+            {
+                yuv = _mm_sub_epi16(yuv, _mm_setr_epi16(16, 128, 16, 128, 16, 128, 16, 128));
+                ce = _mm_shufflehi_epi16(_mm_shufflelo_epi16(yuv, _MM_SHUFFLE(3, 2, 3, 0)), _MM_SHUFFLE(3, 2, 3, 0));
+                cd = _mm_shufflehi_epi16(_mm_shufflelo_epi16(yuv, _MM_SHUFFLE(1, 2, 1, 0)), _MM_SHUFFLE(1, 2, 1, 0));
+            }
+
+            const __m128i round = _mm_set1_epi32(128);
+            r = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(ce, _mm_setr_epi16(298, 409, 298, 409, 298, 409, 298, 409)), round), 8);
+            g = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(
+                _mm_madd_epi16(cd, _mm_setr_epi16(298, -100, 298, -100, 298, -100, 298, -100)),
+                _mm_madd_epi16(ce, _mm_setr_epi16(0, -208, 0, -208, 0, -208, 0, -208))), round), 8);
+            b = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cd, _mm_setr_epi16(298, 516, 298, 516, 298, 516, 298, 516)), round), 8);
+        }
+
+        // Converts 16 pixels into 16 bytes each of R, G and B.
+        template<bool Uyvy>
+        inline void convert16(const uint8_t * src, __m128i & r, __m128i & g, __m128i & b)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i in0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+            const __m128i in1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 16));
+
+            __m128i r32[4], g32[4], b32[4];
+            convert4<Uyvy>(_mm_unpacklo_epi8(in0, zero), r32[0], g32[0], b32[0]);
+            convert4<Uyvy>(_mm_unpackhi_epi8(in0, zero), r32[1], g32[1], b32[1]);
+            convert4<Uyvy>(_mm_unpacklo_epi8(in1, zero), r32[2], g32[2], b32[2]);
+            convert4<Uyvy>(_mm_unpackhi_epi8(in1, zero), r32[3], g32[3], b32[3]);
+
+            // Saturating packs do the clamping.
+            r = _mm_packus_epi16(_mm_packs_epi32(r32[0], r32[1]), _mm_packs_epi32(r32[2], r32[3]));
+            g = _mm_packus_epi16(_mm_packs_epi32(g32[0], g32[1]), _mm_packs_epi32(g32[2], g32[3]));
+            b = _mm_packus_epi16(_mm_packs_epi32(b32[0], b32[1]), _mm_packs_epi32(b32[2], b32[3]));
+        }
+
+        inline void storeInterleaved(uint8_t * dst, __m128i c0, __m128i c1, __m128i c2)
+        {
+            const __m128i alpha = _mm_set1_epi8((char)0xFF);
+            const __m128i c01Lo = _mm_unpacklo_epi8(c0, c1);
+            const __m128i c01Hi = _mm_unpackhi_epi8(c0, c1);
+            const __m128i c23Lo = _mm_unpacklo_epi8(c2, alpha);
+            const __m128i c23Hi = _mm_unpackhi_epi8(c2, alpha);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_unpacklo_epi16(c01Lo, c23Lo));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 16), _mm_unpackhi_epi16(c01Lo, c23Lo));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 32), _mm_unpacklo_epi16(c01Hi, c23Hi));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 48), _mm_unpackhi_epi16(c01Hi, c23Hi));
+        }
+#endif
+
+        template<bool Uyvy>
+        void convertRun(const uint8_t * srcData, size_t numPixels, uint8_t * dstData, ofPixelFormat dstFormat)
+        {
+            size_t i = 0;
+
+#ifdef OFX_REALSENSE2_SSE2
+            __m128i r, g, b;
+            if (dstFormat == OF_PIXELS_RGB)
+            {
+                // SSE2 has no byte shuffle, go through RGBA and drop the alpha.
+                alignas(16) uint8_t rgba[64];
+                for (; i + 16 <= numPixels; i += 16)
+                {
+                    convert16<Uyvy>(srcData + i * 2, r, g, b);
+                    storeInterleaved(rgba, r, g, b);
+
+                    uint8_t * dst = dstData + i * 3;
+                    for (int j = 0; j < 16; ++j)
+                    {
+                        dst[j * 3 + 0] = rgba[j * 4 + 0];
+                        dst[j * 3 + 1] = rgba[j * 4 + 1];
+                        dst[j * 3 + 2] = rgba[j * 4 + 2];
+                    }
+                }
+            }
+            else
+            {
+                const bool bgr = (dstFormat == OF_PIXELS_BGRA);
+                for (; i + 16 <= numPixels; i += 16)
+                {
+                    convert16<Uyvy>(srcData + i * 2, r, g, b);
+                    storeInterleaved(dstData + i * 4, bgr ? b : r, g, bgr ? r : b);
+                }
+            }
+#endif
+
+            convertScalar<Uyvy>(srcData + i * 2, numPixels - i, dstData + i * (dstFormat == OF_PIXELS_RGB ? 3 : 4), dstFormat);
+        }
+    }
+
+    bool ColorConverter::isSupported(rs2_format srcFormat, ofPixelFormat dstFormat)
+    {
+        return (srcFormat == RS2_FORMAT_YUYV || srcFormat == RS2_FORMAT_UYVY) &&
+            (dstFormat == OF_PIXELS_RGB || dstFormat == OF_PIXELS_RGBA || dstFormat == OF_PIXELS_BGRA);
+    }
+
+    void ColorConverter::convert(const uint8_t * srcData, size_t numPixels, rs2_format srcFormat, uint8_t * dstData, ofPixelFormat dstFormat)
+    {
+        if (!isSupported(srcFormat, dstFormat)) return;
+
+        if (srcFormat == RS2_FORMAT_UYVY)
+        {
+            convertRun<true>(srcData, numPixels, dstData, dstFormat);
+        }
+        else
+        {
+            convertRun<false>(srcData, numPixels, dstData, dstFormat);
+        }
+    }
+
+    void ColorConverter::convert(const uint8_t * srcData, int width, int height, int srcStride, rs2_format srcFormat, uint8_t * dstData, ofPixelFormat dstFormat)
+    {
+        if (!isSupported(srcFormat, dstFormat) || width <= 0 || height <= 0) return;
+
+        const int dstStride = width * (dstFormat == OF_PIXELS_RGB ? 3 : 4);
+
+        auto & pool = ThreadPool::getShared();
+        const int numStrips = std::max(1, std::min(pool.getConcurrency(), height / 32));
+        pool.parallelFor(numStrips, [&](int s)
+        {
+            const int y0 = height * s / numStrips;
+            const int y1 = height * (s + 1) / numStrips;
+            if (srcStride == width * 2)
+            {
+                // Tightly packed rows convert as a single run.
+                convert(srcData + size_t(y0) * srcStride, size_t(width) * (y1 - y0), srcFormat, dstData + size_t(y0) * dstStride, dstFormat);
+            }
+            else
+            {
+                for (int y = y0; y < y1; ++y)
+                {
+                    convert(srcData + size_t(y) * srcStride, width, srcFormat, dstData + size_t(y) * dstStride, dstFormat);
+                }
+            }
+        });
+    }
+}
\ No newline at end of file
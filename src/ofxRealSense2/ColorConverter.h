@@ -0,0 +1,26 @@
+#pragma once
+
+#include "librealsense2/rs.hpp"
+
+#include "ofPixels.h"
+
+#include <cstdint>
+
+namespace ofxRealSense2
+{
+    // Packed YUV 4:2:2 (YUYV or UYVY) to RGB, RGBA or BGRA conversion, using
+    // the same integer BT.601 limited range math as librealsense. Requesting
+    // YUV from the camera takes 2 bytes per pixel on USB instead of 3.
+    class ColorConverter
+    {
+    public:
+        static bool isSupported(rs2_format srcFormat, ofPixelFormat dstFormat);
+
+        // Converts a run of pixels, the count must be even.
+        static void convert(const uint8_t * srcData, size_t numPixels, rs2_format srcFormat, uint8_t * dstData, ofPixelFormat dstFormat);
+
+        // Converts an image in strips on the shared thread pool. The width must be even
+        // and the destination rows are tightly packed.
+        static void convert(const uint8_t * srcData, int width, int height, int srcStride, rs2_format srcFormat, uint8_t * dstData, ofPixelFormat dstFormat);
+    };
+}
\ No newline at end of file
@@ -5,6 +5,8 @@
 namespace ofxRealSense2
 {
     Context::Context()
+        : pollInterval(1.0f)
+        , pollStopping(false)
     {
 
     }
@@ -39,31 +41,189 @@ namespace ofxRealSense2
 
     void Context::clear()
     {
-        auto it = this->devices.begin();
-        while (it != this->devices.end())
-        {
-            it->second->stopPipeline();
-            ++it;
-        }
+        this->stopPolling();
+        this->stopDevices();
+
+        std::lock_guard<std::mutex> lock(this->mutex);
         this->devices.clear();
 
         this->context.reset();
     }
 
-    void Context::update()
+    void Context::startDevices()
     {
         std::lock_guard<std::mutex> lock(this->mutex);
-        for (auto it : this->devices)
+        for (auto & it : this->devices)
         {
-            if (it.second->isRunning())
+            if (!it.second->isRunning())
             {
-                //it.second->pollForFrames();
-                //it.second->updateData();
-                it.second->update();
+                this->startDevice(it.first);
             }
         }
     }
 
+    void Context::stopDevices()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        // Let starts in progress finish first, so they can't start a device after it was stopped.
+        this->startRequests.clear();
+        for (auto & it : this->pendingStarts)
+        {
+            it.second.wait();
+        }
+        this->pendingStarts.clear();
+
+        std::vector<std::future<void>> stops;
+        for (auto & it : this->devices)
+        {
+            stops.push_back(it.second->stopPipelineAsync());
+        }
+        for (auto & stop : stops)
+        {
+            stop.wait();
+        }
+    }
+
+    void Context::update()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+
+        // Devices added from the librealsense callback start here, so their parameters are built on this thread.
+        for (const auto & serialNumber : this->startRequests)
+        {
+            if (this->devices.count(serialNumber) && !this->devices.at(serialNumber)->isRunning())
+            {
+                this->startDevice(serialNumber);
+            }
+        }
+        this->startRequests.clear();
+
+        // Report devices that finished starting.
+        auto pendingIt = this->pendingStarts.begin();
+        while (pendingIt != this->pendingStarts.end())
+        {
+            if (pendingIt->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                ++pendingIt;
+                continue;
+            }
+
+            auto serialNumber = pendingIt->first;
+            try
+            {
+                pendingIt->second.get();
+                ofLogNotice(__FUNCTION__) << "Device " << serialNumber << " ready";
+                this->readyDevices.push_back(serialNumber);
+            }
+            catch (std::exception & e)
+            {
+                ofLogError(__FUNCTION__) << "Device " << serialNumber << " failed to start: " << e.what();
+            }
+            pendingIt = this->pendingStarts.erase(pendingIt);
+        }
+
+        this->updateDevices.clear();
+        for (auto & it : this->devices)
+        {
+            // Devices still starting are left alone until they are reported ready.
+            if (it.second->isRunning() && !this->pendingStarts.count(it.first))
+            {
+                this->updateDevices.push_back(it.second.get());
+            }
+        }
+
+        // Device updates only stage frame data, so they can run side by side.
+        // GL uploads happen later on this thread, when the textures are read.
+        ThreadPool::getShared().parallelFor((int)this->updateDevices.size(), [this](int i)
+        {
+            this->updateDevices[i]->updateFrames();
+        });
+
+        // Events go out on this thread.
+        for (auto device : this->updateDevices)
+        {
+            device->updateEvents();
+        }
+
+        // Listeners may start or stop devices, which takes the lock again.
+        lock.unlock();
+        for (const auto & serialNumber : this->readyDevices)
+        {
+            this->deviceReadyEvent.notify(serialNumber);
+        }
+        this->readyDevices.clear();
+    }
+
+    void Context::startPolling(const std::vector<rs2_option> & options, float interval)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->pollMutex);
+            this->pollOptions = options;
+            this->pollInterval = std::max(interval, 0.01f);
+        }
+
+        if (!this->pollThread.joinable())
+        {
+            this->pollStopping = false;
+            this->pollThread = std::thread(&Context::pollLoop, this);
+        }
+    }
+
+    void Context::stopPolling()
+    {
+        if (!this->pollThread.joinable()) return;
+
+        {
+            std::lock_guard<std::mutex> lock(this->pollMutex);
+            this->pollStopping = true;
+        }
+        this->pollCondition.notify_all();
+        this->pollThread.join();
+    }
+
+    void Context::pollLoop()
+    {
+        std::vector<std::shared_ptr<Device>> pollDevices;
+        std::vector<rs2_option> options;
+
+        std::unique_lock<std::mutex> pollLock(this->pollMutex);
+        while (!this->pollStopping)
+        {
+            options = this->pollOptions;
+            const auto interval = std::chrono::duration<float>(this->pollInterval);
+            pollLock.unlock();
+
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                for (auto & it : this->devices)
+                {
+                    if (it.second->isRunning())
+                    {
+                        pollDevices.push_back(it.second);
+                    }
+                }
+            }
+
+            for (auto & device : pollDevices)
+            {
+                for (auto option : options)
+                {
+                    device->pollOption(option);
+                }
+            }
+
+            // Don't keep removed devices alive while waiting.
+            pollDevices.clear();
+
+            pollLock.lock();
+            this->pollCondition.wait_for(pollLock, interval, [this]
+            {
+                return this->pollStopping;
+            });
+        }
+    }
+
     void Context::addDevice(rs2::device& device)
     {
         auto serialNumber = std::string(device.get_info(RS2_CAMERA_INFO_SERIAL_NUMBER));
@@ -89,34 +249,66 @@ namespace ofxRealSense2
 
         if (this->autoStart)
         {
-            // Start the device.
-            ofLogNotice(__FUNCTION__) << "Start device " << serialNumber;
             auto device = this->devices.at(serialNumber);
             device->enableDepth();
             device->enableColor();
-            device->startPipeline();
+            this->startRequests.insert(serialNumber);
         }
     }
 
+    void Context::startDevice(const std::string & serialNumber)
+    {
+        if (this->pendingStarts.count(serialNumber))
+        {
+            // Already starting, update() reports it once.
+            return;
+        }
+
+        // Start in the background, update() reports when it's ready.
+        ofLogNotice(__FUNCTION__) << "Start device " << serialNumber;
+        this->pendingStarts[serialNumber] = this->devices.at(serialNumber)->startPipelineAsync();
+    }
+
     void Context::removeDevices(const rs2::event_information & info)
     {
-        std::lock_guard<std::mutex> lock(this->mutex);
-        // Go over the list of devices and check if it was disconnected.
-        auto it = this->devices.begin();
-        while (it != this->devices.end())
+        std::vector<std::shared_ptr<Device>> removedDevices;
+        std::vector<std::future<void>> removedStarts;
         {
-            if (info.was_removed(it->second->getNativeDevice()))
-            {
-                auto serialNumber = it->first;
-                ofLogNotice(__FUNCTION__) << "Remove device " << serialNumber;
-                this->deviceRemovedEvent.notify(serialNumber);
-                it = this->devices.erase(it);
-            }
-            else
+            std::lock_guard<std::mutex> lock(this->mutex);
+            // Go over the list of devices and check if it was disconnected.
+            auto it = this->devices.begin();
+            while (it != this->devices.end())
             {
-                ++it;
+                if (info.was_removed(it->second->getNativeDevice()))
+                {
+                    auto serialNumber = it->first;
+                    ofLogNotice(__FUNCTION__) << "Remove device " << serialNumber;
+
+                    auto pendingIt = this->pendingStarts.find(serialNumber);
+                    if (pendingIt != this->pendingStarts.end())
+                    {
+                        removedStarts.push_back(std::move(pendingIt->second));
+                        this->pendingStarts.erase(pendingIt);
+                    }
+                    this->startRequests.erase(serialNumber);
+                    this->deviceRemovedEvent.notify(serialNumber);
+                    removedDevices.push_back(it->second);
+                    it = this->devices.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
             }
         }
+
+        // Wait out starts in progress before the devices go away, without holding up update().
+        for (auto & start : removedStarts)
+        {
+            start.wait();
+        }
+        removedStarts.clear();
+        removedDevices.clear();
     }
 
     const std::map<std::string, std::shared_ptr<Device>> & Context::getDevices() const
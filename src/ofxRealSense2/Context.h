@@ -4,6 +4,9 @@
 #include "ofEvent.h"
 #include "librealsense2/rs.hpp"
 #include "Device.h"
+#include "ThreadPool.h"
+
+#include <set>
 
 namespace ofxRealSense2
 {
@@ -16,8 +19,20 @@ namespace ofxRealSense2
         void setup(bool autoStart = true);
         void clear();
 
+        // Starts all stopped devices concurrently, each one notifies deviceReadyEvent from update(),
+        // outside the lock so listeners can start or stop devices.
+        void startDevices();
+        // Stops all running devices concurrently and waits for them.
+        void stopDevices();
+
         void update();
 
+        // Reads the options from every running device at the interval (in seconds) on a
+        // background thread, see Device::getOptionMonitor(). Meant for read-only options
+        // like temperatures, which would stall the main thread on USB.
+        void startPolling(const std::vector<rs2_option> & options, float interval = 1.0f);
+        void stopPolling();
+
         const std::map<std::string, std::shared_ptr<Device>> & getDevices() const;
         std::shared_ptr<Device> getDevice(const std::string & serialNumber) const;
         std::shared_ptr<Device> getDevice(int idx = 0) const;
@@ -28,15 +43,31 @@ namespace ofxRealSense2
     public:
         ofEvent<std::string> deviceAddedEvent;
         ofEvent<std::string> deviceRemovedEvent;
+        ofEvent<std::string> deviceReadyEvent;
 
     private:
         void addDevice(rs2::device& device);
         void removeDevices(const rs2::event_information & info);
+        void startDevice(const std::string & serialNumber);
+        void pollLoop();
 
     private:
         std::shared_ptr<rs2::context> context;
         std::mutex mutex;
         std::map<std::string, std::shared_ptr<Device>> devices;
+        std::map<std::string, std::future<void>> pendingStarts;
+        std::set<std::string> startRequests;
         bool autoStart;
+
+        std::vector<Device *> updateDevices;
+        // Started since the last update, notified once the lock is released.
+        std::vector<std::string> readyDevices;
+
+        std::thread pollThread;
+        std::mutex pollMutex;
+        std::condition_variable pollCondition;
+        std::vector<rs2_option> pollOptions;
+        float pollInterval;
+        bool pollStopping;
     };
 }
\ No newline at end of file
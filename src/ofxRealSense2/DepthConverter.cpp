@@ -0,0 +1,87 @@
+#include "DepthConverter.h"
+
+#include "Simd.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ofxRealSense2
+{
+    namespace
+    {
+        // The colorizer looks colors up in a table of this many steps.
+        const int ColorMapSteps = 4000;
+
+        inline uint8_t whiteToBlack(float t)
+        {
+            const int step = (int)(std::min(std::max(t, 0.0f), 1.0f) * (ColorMapSteps - 1));
+            return (uint8_t)(255.0f * (1.0f - step / float(ColorMapSteps - 1)));
+        }
+    }
+
+    void DepthConverter::toMeters(const uint16_t * depthData, size_t numPixels, float depthScale, float invalidValue, float * metersData)
+    {
+        size_t i = 0;
+
+#ifdef OFX_REALSENSE2_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 scale = _mm_set1_ps(depthScale);
+        const __m128 invalid = _mm_set1_ps(invalidValue);
+        for (; i + 8 <= numPixels; i += 8)
+        {
+            const __m128i depth = _mm_loadu_si128(reinterpret_cast<const __m128i *>(depthData + i));
+            const __m128i missing = _mm_cmpeq_epi16(depth, zero);
+
+            const __m128 metersA = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(depth, zero)), scale);
+            const __m128 metersB = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(depth, zero)), scale);
+
+            // Widen the 16-bit mask to 32 bits and select the invalid value where it is set.
+            const __m128 missingA = _mm_castsi128_ps(_mm_unpacklo_epi16(missing, missing));
+            const __m128 missingB = _mm_castsi128_ps(_mm_unpackhi_epi16(missing, missing));
+            _mm_storeu_ps(metersData + i, _mm_or_ps(_mm_andnot_ps(missingA, metersA), _mm_and_ps(missingA, invalid)));
+            _mm_storeu_ps(metersData + i + 4, _mm_or_ps(_mm_andnot_ps(missingB, metersB), _mm_and_ps(missingB, invalid)));
+        }
+#endif
+
+        for (; i < numPixels; ++i)
+        {
+            metersData[i] = depthData[i] ? depthData[i] * depthScale : invalidValue;
+        }
+    }
+
+    void DepthConverter::toGray(const uint16_t * depthData, size_t numPixels, float depthScale, float minDistance, float maxDistance, uint8_t * rgbData)
+    {
+        // An empty range would divide by zero, treat it as a step.
+        const float range = std::max(maxDistance - minDistance, 1e-6f);
+        for (size_t i = 0; i < numPixels; ++i)
+        {
+            const uint8_t gray = depthData[i] ? whiteToBlack((depthData[i] * depthScale - minDistance) / range) : 0;
+            rgbData[i * 3 + 0] = gray;
+            rgbData[i * 3 + 1] = gray;
+            rgbData[i * 3 + 2] = gray;
+        }
+    }
+
+    void DepthConverter::toGrayEqualized(const uint16_t * depthData, size_t numPixels, uint32_t * histogram, uint8_t * rgbData)
+    {
+        // Cumulative histogram of the valid depth, so each value maps to the share of pixels up to it.
+        std::memset(histogram, 0, HistogramSize * sizeof(uint32_t));
+        for (size_t i = 0; i < numPixels; ++i)
+        {
+            ++histogram[depthData[i]];
+        }
+        for (size_t i = 2; i < HistogramSize; ++i)
+        {
+            histogram[i] += histogram[i - 1];
+        }
+
+        const float total = (float)std::max<uint32_t>(histogram[HistogramSize - 1], 1);
+        for (size_t i = 0; i < numPixels; ++i)
+        {
+            const uint8_t gray = depthData[i] ? whiteToBlack(histogram[depthData[i]] / total) : 0;
+            rgbData[i * 3 + 0] = gray;
+            rgbData[i * 3 + 1] = gray;
+            rgbData[i * 3 + 2] = gray;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ofxRealSense2
+{
+    // Conversions of raw Z16 depth.
+    class DepthConverter
+    {
+    public:
+        // Scales raw depth to meters. Zero depth is missing data and is written
+        // as the invalid value, which can be NaN.
+        static void toMeters(const uint16_t * depthData, size_t numPixels, float depthScale, float invalidValue, float * metersData);
+
+        // Colors raw depth into RGB pixels like rs2::colorizer with the white to
+        // black scheme: near is white, far is black and missing depth is black.
+        // Depth maps linearly from the min to the max distance in meters.
+        static void toGray(const uint16_t * depthData, size_t numPixels, float depthScale, float minDistance, float maxDistance, uint8_t * rgbData);
+        // Same with histogram equalization, depth maps by its rank in the frame.
+        // The histogram is scratch space for HistogramSize counts.
+        static void toGrayEqualized(const uint16_t * depthData, size_t numPixels, uint32_t * histogram, uint8_t * rgbData);
+
+        static const size_t HistogramSize = 0x10000;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "DepthMesh.h"
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ofxRealSense2
+{
+    namespace
+    {
+        inline bool isContinuous(float a, float b, float c, float maxDiscontinuity)
+        {
+            const float nearest = std::min(a, std::min(b, c));
+            const float farthest = std::max(a, std::max(b, c));
+            return nearest > 0.0f && farthest - nearest <= maxDiscontinuity * nearest;
+        }
+    }
+
+    DepthMesh::DepthMesh()
+        : rayIntrinsics()
+        , step(0)
+        , gridWidth(0)
+        , gridHeight(0)
+    {
+
+    }
+
+    void DepthMesh::update(const uint16_t * depthData, const Intrinsics & intrinsics, float depthScale, int step, float maxDiscontinuity, ofMesh & mesh)
+    {
+        step = std::max(step, 1);
+        this->updateRays(intrinsics, step);
+
+        const int width = intrinsics.getWidth();
+        const int gridWidth = this->gridWidth;
+        const int gridHeight = this->gridHeight;
+        const size_t numVertices = size_t(gridWidth) * gridHeight;
+        const size_t numCellRows = std::max(gridHeight - 1, 0);
+        const size_t indicesPerRow = size_t(std::max(gridWidth - 1, 0)) * 6;
+
+        auto & vertices = mesh.getVertices();
+        auto & texCoords = mesh.getTexCoords();
+        auto & indices = mesh.getIndices();
+        vertices.resize(numVertices);
+        texCoords.resize(numVertices);
+        // Every triangle keeps its slot, culled ones are collapsed in place.
+        indices.resize(this->gridIndices.size());
+
+        auto & pool = ThreadPool::getShared();
+        const int numStrips = std::max(1, std::min(pool.getConcurrency(), gridHeight / 16));
+
+        // Vertices first, the triangles of a strip read the first row of the next one.
+        const glm::vec2 texScale(1.0f / std::max(intrinsics.getWidth(), 1), 1.0f / std::max(intrinsics.getHeight(), 1));
+        pool.parallelFor(numStrips, [&](int s)
+        {
+            const int y0 = gridHeight * s / numStrips;
+            const int y1 = gridHeight * (s + 1) / numStrips;
+            for (int y = y0; y < y1; ++y)
+            {
+                const uint16_t * depthRow = depthData + size_t(y) * step * width;
+                const size_t rowStart = size_t(y) * gridWidth;
+                for (int x = 0; x < gridWidth; ++x)
+                {
+                    // Missing depth gives a zero vertex, which only degenerate triangles reference.
+                    const float depth = depthRow[x * step] * depthScale;
+                    vertices[rowStart + x] = this->rays[rowStart + x] * depth;
+                    texCoords[rowStart + x] = glm::vec2(x * step + 0.5f, y * step + 0.5f) * texScale;
+                }
+            }
+        });
+
+        // Cell rows in strips, each cell owns the same six indices every frame.
+        pool.parallelFor(numStrips, [&](int s)
+        {
+            const size_t y0 = numCellRows * s / numStrips;
+            const size_t y1 = numCellRows * (s + 1) / numStrips;
+            const ofIndexType * cell = this->gridIndices.data() + y0 * indicesPerRow;
+            const ofIndexType * cellEnd = this->gridIndices.data() + y1 * indicesPerRow;
+            ofIndexType * out = indices.data() + y0 * indicesPerRow;
+            for (; cell != cellEnd; cell += 6, out += 6)
+            {
+                // Cells are a, c, b then b, c, d, with b right of a and c below it.
+                const float za = vertices[cell[0]].z;
+                const float zb = vertices[cell[2]].z;
+                const float zc = vertices[cell[1]].z;
+                const float zd = vertices[cell[5]].z;
+
+                if (isContinuous(za, zc, zb, maxDiscontinuity))
+                {
+                    out[0] = cell[0];
+                    out[1] = cell[1];
+                    out[2] = cell[2];
+                }
+                else
+                {
+                    out[0] = out[1] = out[2] = cell[0];
+                }
+                if (isContinuous(zb, zc, zd, maxDiscontinuity))
+                {
+                    out[3] = cell[3];
+                    out[4] = cell[4];
+                    out[5] = cell[5];
+                }
+                else
+                {
+                    out[3] = out[4] = out[5] = cell[3];
+                }
+            }
+        });
+    }
+
+    int DepthMesh::getGridWidth() const
+    {
+        return this->gridWidth;
+    }
+
+    int DepthMesh::getGridHeight() const
+    {
+        return this->gridHeight;
+    }
+
+    void DepthMesh::updateRays(const Intrinsics & intrinsics, int step)
+    {
+        const auto & native = intrinsics.getNative();
+        if (step == this->step && std::memcmp(&native, &this->rayIntrinsics, sizeof(rs2_intrinsics)) == 0) return;
+
+        this->rayIntrinsics = native;
+        this->step = step;
+        this->gridWidth = intrinsics.isValid() ? (native.width + step - 1) / step : 0;
+        this->gridHeight = intrinsics.isValid() ? (native.height + step - 1) / step : 0;
+
+        this->rays.resize(size_t(this->gridWidth) * this->gridHeight);
+        for (int y = 0; y < this->gridHeight; ++y)
+        {
+            for (int x = 0; x < this->gridWidth; ++x)
+            {
+                this->rays[size_t(y) * this->gridWidth + x] = intrinsics.deproject(glm::vec2(x * step, y * step), 1.0f);
+            }
+        }
+
+        // Two triangles per cell, the layout only changes with the grid.
+        this->gridIndices.resize(size_t(std::max(this->gridWidth - 1, 0)) * std::max(this->gridHeight - 1, 0) * 6);
+        ofIndexType * out = this->gridIndices.data();
+        for (int y = 0; y + 1 < this->gridHeight; ++y)
+        {
+            for (int x = 0; x + 1 < this->gridWidth; ++x)
+            {
+                const auto a = ofIndexType(size_t(y) * this->gridWidth + x);
+                const auto b = a + 1;
+                const auto c = a + this->gridWidth;
+                const auto d = c + 1;
+                *out++ = a;
+                *out++ = c;
+                *out++ = b;
+                *out++ = b;
+                *out++ = c;
+                *out++ = d;
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "ofMesh.h"
+
+#include "Intrinsics.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace ofxRealSense2
+{
+    // Triangulates the organized depth grid into a surface, two triangles per
+    // grid cell. Triangles touching a pixel without depth, or spanning a depth
+    // jump larger than a fraction of their distance, are collapsed to a point
+    // so separate surfaces don't get bridged. The index buffer keeps the same
+    // layout for a given grid. Vertices are in meters in depth camera space,
+    // and texture coordinates are normalized over the depth image.
+    class DepthMesh
+    {
+    public:
+        DepthMesh();
+
+        // Samples every step pixels, writes vertices, texture coordinates and
+        // indices into the mesh, reusing its buffers.
+        void update(const uint16_t * depthData, const Intrinsics & intrinsics, float depthScale, int step, float maxDiscontinuity, ofMesh & mesh);
+
+        int getGridWidth() const;
+        int getGridHeight() const;
+
+    private:
+        void updateRays(const Intrinsics & intrinsics, int step);
+
+    private:
+        // Deprojection of each grid point at one meter, deprojection scales with depth.
+        std::vector<glm::vec3> rays;
+        rs2_intrinsics rayIntrinsics;
+        int step;
+        int gridWidth;
+        int gridHeight;
+
+        // Indices of every triangle of the grid, rebuilt with the rays.
+        std::vector<ofIndexType> gridIndices;
+    };
+}
\ No newline at end of file
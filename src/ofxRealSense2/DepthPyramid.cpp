@@ -0,0 +1,205 @@
+#include "DepthPyramid.h"
+
+#include "Simd.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace ofxRealSense2
+{
+    namespace
+    {
+        inline uint16_t reduceBlock(uint16_t a, uint16_t b, uint16_t c, uint16_t d, DepthPyramid::Mode mode)
+        {
+            uint16_t values[4];
+            int count = 0;
+            if (a) values[count++] = a;
+            if (b) values[count++] = b;
+            if (c) values[count++] = c;
+            if (d) values[count++] = d;
+            if (!count) return 0;
+
+            if (mode == DepthPyramid::Min)
+            {
+                return *std::min_element(values, values + count);
+            }
+
+            if (mode == DepthPyramid::Mean)
+            {
+                uint32_t sum = 0;
+                for (int i = 0; i < count; ++i)
+                {
+                    sum += values[i];
+                }
+                return (uint16_t)((sum + count / 2) / count);
+            }
+
+            // Median, even counts average the middle pair.
+            std::sort(values, values + count);
+            if (count & 1)
+            {
+                return values[count / 2];
+            }
+            return (uint16_t)((uint32_t(values[count / 2 - 1]) + values[count / 2] + 1) / 2);
+        }
+
+#ifdef OFX_REALSENSE2_SSE2
+        // Packs 32-bit lanes holding 16-bit unsigned values, packs_epi32 alone would saturate.
+        inline __m128i packUnsigned(__m128i a, __m128i b)
+        {
+            const __m128i bias32 = _mm_set1_epi32(0x8000);
+            const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+            return _mm_add_epi16(_mm_packs_epi32(_mm_sub_epi32(a, bias32), _mm_sub_epi32(b, bias32)), bias16);
+        }
+
+        // Reduces 8 source columns of two rows into 4 pixels, one per 32-bit lane.
+        inline __m128i reduceMin4(__m128i row0, __m128i row1)
+        {
+            // Missing depth wraps to the largest value, then unsigned min via a sign flip.
+            const __m128i one = _mm_set1_epi16(1);
+            const __m128i flip = _mm_set1_epi16((short)0x8000);
+            const __m128i a = _mm_xor_si128(_mm_sub_epi16(row0, one), flip);
+            const __m128i b = _mm_xor_si128(_mm_sub_epi16(row1, one), flip);
+            const __m128i vertical = _mm_min_epi16(a, b);
+            const __m128i block = _mm_min_epi16(vertical, _mm_srli_epi32(vertical, 16));
+            // Back to unsigned, an all-missing block wraps back to zero.
+            const __m128i value = _mm_add_epi16(_mm_xor_si128(block, flip), one);
+            return _mm_and_si128(value, _mm_set1_epi32(0xFFFF));
+        }
+
+        inline __m128i reduceMean4(__m128i row0, __m128i row1)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i low = _mm_set1_epi32(0xFFFF);
+            const __m128i sums = _mm_add_epi32(
+                _mm_add_epi32(_mm_and_si128(row0, low), _mm_srli_epi32(row0, 16)),
+                _mm_add_epi32(_mm_and_si128(row1, low), _mm_srli_epi32(row1, 16)));
+
+            // Pairwise adds of the valid flags give the count per block.
+            const __m128i ones = _mm_set1_epi16(1);
+            const __m128i valid0 = _mm_andnot_si128(_mm_cmpeq_epi16(row0, zero), ones);
+            const __m128i valid1 = _mm_andnot_si128(_mm_cmpeq_epi16(row1, zero), ones);
+            const __m128i counts = _mm_madd_epi16(_mm_add_epi16(valid0, valid1), ones);
+
+            // Rounds in integers like the scalar (sum + count / 2) / count. Sums stay below 2^24,
+            // so the float divide is exact enough for truncation to give the integer quotient.
+            const __m128i rounded = _mm_add_epi32(sums, _mm_srli_epi32(counts, 1));
+            const __m128 quotient = _mm_div_ps(_mm_cvtepi32_ps(rounded), _mm_cvtepi32_ps(_mm_max_epi16(counts, _mm_set1_epi32(1))));
+            return _mm_cvttps_epi32(quotient);
+        }
+#endif
+    }
+
+    DepthPyramid::DepthPyramid()
+        : numLevels(0)
+        , mode(Min)
+    {
+
+    }
+
+    void DepthPyramid::update(const uint16_t * depthData, int width, int height, int numLevels, Mode mode)
+    {
+        this->mode = mode;
+        this->numLevels = 0;
+        if (this->levels.size() < size_t(numLevels))
+        {
+            this->levels.resize(numLevels);
+        }
+
+        const uint16_t * srcData = depthData;
+        int srcWidth = width;
+        int srcHeight = height;
+        for (int i = 0; i < numLevels; ++i)
+        {
+            const int dstWidth = srcWidth / 2;
+            const int dstHeight = srcHeight / 2;
+            if (dstWidth < 1 || dstHeight < 1) break;
+
+            auto & level = this->levels[i];
+            if (level.getWidth() != size_t(dstWidth) || level.getHeight() != size_t(dstHeight))
+            {
+                level.allocate(dstWidth, dstHeight, OF_IMAGE_GRAYSCALE);
+            }
+            reduce(srcData, srcWidth, srcHeight, mode, level.getData());
+            ++this->numLevels;
+
+            srcData = level.getData();
+            srcWidth = dstWidth;
+            srcHeight = dstHeight;
+        }
+    }
+
+    void DepthPyramid::swap(DepthPyramid & other)
+    {
+        std::swap(this->levels, other.levels);
+        std::swap(this->numLevels, other.numLevels);
+        std::swap(this->mode, other.mode);
+    }
+
+    int DepthPyramid::getNumLevels() const
+    {
+        return this->numLevels;
+    }
+
+    DepthPyramid::Mode DepthPyramid::getMode() const
+    {
+        return this->mode;
+    }
+
+    const ofShortPixels & DepthPyramid::getLevel(int level) const
+    {
+        static const ofShortPixels empty;
+        if (level < 0 || level >= this->numLevels) return empty;
+
+        return this->levels[level];
+    }
+
+    void DepthPyramid::reduce(const uint16_t * srcData, int srcWidth, int srcHeight, Mode mode, uint16_t * dstData)
+    {
+        const int dstHeight = srcHeight / 2;
+
+        // Each output row reads two adjacent input rows, rows split cleanly across threads.
+        auto & pool = ThreadPool::getShared();
+        const int numStrips = std::max(1, std::min(pool.getConcurrency(), dstHeight / 16));
+        pool.parallelFor(numStrips, [&](int s)
+        {
+            reduceRows(srcData, srcWidth, dstHeight * s / numStrips, dstHeight * (s + 1) / numStrips, mode, dstData);
+        });
+    }
+
+    void DepthPyramid::reduceRows(const uint16_t * srcData, int srcWidth, int y0, int y1, Mode mode, uint16_t * dstData)
+    {
+        const int dstWidth = srcWidth / 2;
+        for (int y = y0; y < y1; ++y)
+        {
+            const uint16_t * row0 = srcData + size_t(y * 2) * srcWidth;
+            const uint16_t * row1 = row0 + srcWidth;
+            uint16_t * dst = dstData + size_t(y) * dstWidth;
+
+            int x = 0;
+
+#ifdef OFX_REALSENSE2_SSE2
+            if (mode != Median)
+            {
+                // 16 source columns into 8 pixels per step.
+                for (; x + 8 <= dstWidth; x += 8)
+                {
+                    const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 2));
+                    const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 2 + 8));
+                    const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 2));
+                    const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 2 + 8));
+                    const __m128i packed = (mode == Min) ?
+                        packUnsigned(reduceMin4(a0, b0), reduceMin4(a1, b1)) :
+                        packUnsigned(reduceMean4(a0, b0), reduceMean4(a1, b1));
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), packed);
+                }
+            }
+#endif
+
+            for (; x < dstWidth; ++x)
+            {
+                dst[x] = reduceBlock(row0[x * 2], row0[x * 2 + 1], row1[x * 2], row1[x * 2 + 1], mode);
+            }
+        }
+    }
+}
\ No newline at end of file
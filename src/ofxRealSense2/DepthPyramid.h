@@ -0,0 +1,46 @@
+#pragma once
+
+#include "ofPixels.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace ofxRealSense2
+{
+    // Raw depth at decreasing resolutions, each level half the size of the one
+    // before it. Every level pixel reduces a 2x2 block of the level above,
+    // ignoring pixels without depth, so a block is only empty if all 4 are.
+    class DepthPyramid
+    {
+    public:
+        enum Mode
+        {
+            // Nearest depth, conservative for obstacles.
+            Min,
+            Median,
+            Mean
+        };
+
+        DepthPyramid();
+
+        // Builds up to numLevels levels, stopping early once a level would be empty.
+        void update(const uint16_t * depthData, int width, int height, int numLevels, Mode mode);
+        void swap(DepthPyramid & other);
+
+        int getNumLevels() const;
+        Mode getMode() const;
+
+        // Level 0 is half the depth resolution, level 1 a quarter and so on.
+        const ofShortPixels & getLevel(int level) const;
+
+        static void reduce(const uint16_t * srcData, int srcWidth, int srcHeight, Mode mode, uint16_t * dstData);
+
+    private:
+        static void reduceRows(const uint16_t * srcData, int srcWidth, int y0, int y1, Mode mode, uint16_t * dstData);
+
+    private:
+        std::vector<ofShortPixels> levels;
+        int numLevels;
+        Mode mode;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,253 @@
+#include "DepthRenderer.h"
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ofxRealSense2
+{
+    namespace
+    {
+        const uint32_t EmptyDepth = 0xFFFFFFFF;
+
+        // Inverse of a rigid transform, the rotation is transposed.
+        glm::mat4 invertRigid(const glm::mat4 & pose)
+        {
+            const glm::vec3 axisX(pose[0]);
+            const glm::vec3 axisY(pose[1]);
+            const glm::vec3 axisZ(pose[2]);
+            const glm::vec3 origin(pose[3]);
+
+            glm::mat4 inverse;
+            inverse[0] = glm::vec4(axisX.x, axisY.x, axisZ.x, 0.0f);
+            inverse[1] = glm::vec4(axisX.y, axisY.y, axisZ.y, 0.0f);
+            inverse[2] = glm::vec4(axisX.z, axisY.z, axisZ.z, 0.0f);
+            inverse[3] = glm::vec4(-glm::dot(axisX, origin), -glm::dot(axisY, origin), -glm::dot(axisZ, origin), 1.0f);
+            return inverse;
+        }
+
+        inline void atomicMin(std::atomic<uint32_t> & target, uint32_t value)
+        {
+            uint32_t current = target.load(std::memory_order_relaxed);
+            while (value < current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+            {
+            }
+        }
+    }
+
+    DepthRenderer::DepthRenderer()
+        : orthographic(false)
+        , width(0)
+        , height(0)
+        , fx(1.0f)
+        , fy(1.0f)
+        , ppx(0.0f)
+        , ppy(0.0f)
+        , depthScale(0.001f)
+        , splatRadius(0)
+        , tilesX(0)
+        , tilesY(0)
+        , zBufferSize(0)
+    {
+
+    }
+
+    void DepthRenderer::setupPerspective(const Intrinsics & intrinsics, const glm::mat4 & pose, float depthScale)
+    {
+        // The view is virtual, so it has no lens distortion.
+        const auto & native = intrinsics.getNative();
+        this->orthographic = false;
+        this->fx = native.fx;
+        this->fy = native.fy;
+        this->ppx = native.ppx;
+        this->ppy = native.ppy;
+        this->pose = pose;
+        this->depthScale = depthScale;
+        this->allocate(native.width, native.height);
+    }
+
+    void DepthRenderer::setupOrthographic(int width, int height, float pixelSize, const glm::mat4 & pose, float depthScale)
+    {
+        // Same mapping as a pinhole at unit depth, with the pixel center at the image center.
+        this->orthographic = true;
+        this->fx = this->fy = 1.0f / pixelSize;
+        this->ppx = width * 0.5f - 0.5f;
+        this->ppy = height * 0.5f - 0.5f;
+        this->pose = pose;
+        this->depthScale = depthScale;
+        this->allocate(width, height);
+    }
+
+    void DepthRenderer::setSplatRadius(int splatRadius)
+    {
+        this->splatRadius = std::max(splatRadius, 0);
+    }
+
+    void DepthRenderer::begin()
+    {
+        const size_t rowSize = size_t(this->tilesX) * TileSize * TileSize;
+        ThreadPool::getShared().parallelFor(this->tilesY, [&](int tileY)
+        {
+            for (size_t i = tileY * rowSize; i < (tileY + 1) * rowSize; ++i)
+            {
+                this->zBuffer[i].store(EmptyDepth, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    void DepthRenderer::addDepth(const uint16_t * depthData, const Intrinsics & intrinsics, float depthScale, const glm::mat4 & pose)
+    {
+        if (!intrinsics.isValid() || !this->zBufferSize) return;
+
+        const glm::mat4 transform = this->getViewTransform(pose);
+        const int width = intrinsics.getWidth();
+        const int height = intrinsics.getHeight();
+
+        // Source rows in strips, the z-buffer takes concurrent writes.
+        auto & pool = ThreadPool::getShared();
+        const int numStrips = std::max(1, std::min(pool.getConcurrency(), height / 16));
+        pool.parallelFor(numStrips, [&](int s)
+        {
+            const int y0 = height * s / numStrips;
+            const int y1 = height * (s + 1) / numStrips;
+            for (int y = y0; y < y1; ++y)
+            {
+                const uint16_t * depthRow = depthData + size_t(y) * width;
+                for (int x = 0; x < width; ++x)
+                {
+                    if (!depthRow[x]) continue;
+
+                    const glm::vec3 point = intrinsics.deproject(glm::vec2(x, y), depthRow[x] * depthScale);
+                    this->splat(glm::vec3(transform * glm::vec4(point, 1.0f)));
+                }
+            }
+        });
+    }
+
+    void DepthRenderer::addPoints(const glm::vec3 * points, size_t count, const glm::mat4 & pose)
+    {
+        if (!this->zBufferSize) return;
+
+        const glm::mat4 transform = this->getViewTransform(pose);
+        auto & pool = ThreadPool::getShared();
+        const int numChunks = (int)std::max<size_t>(1, std::min<size_t>(pool.getConcurrency(), count / 4096));
+        pool.parallelFor(numChunks, [&](int c)
+        {
+            const size_t start = count * c / numChunks;
+            const size_t end = count * (c + 1) / numChunks;
+            for (size_t i = start; i < end; ++i)
+            {
+                // Points without depth are at the origin.
+                if (points[i].z <= 0.0f) continue;
+
+                this->splat(glm::vec3(transform * glm::vec4(points[i], 1.0f)));
+            }
+        });
+    }
+
+    void DepthRenderer::end()
+    {
+        if (this->depthPix.getWidth() != size_t(this->width) || this->depthPix.getHeight() != size_t(this->height))
+        {
+            this->depthPix.allocate(this->width, this->height, OF_IMAGE_GRAYSCALE);
+        }
+
+        // Untile a row of tiles at a time.
+        uint16_t * depthData = this->depthPix.getData();
+        ThreadPool::getShared().parallelFor(this->tilesY, [&](int tileY)
+        {
+            const int y0 = tileY * TileSize;
+            const int y1 = std::min(y0 + TileSize, this->height);
+            for (int y = y0; y < y1; ++y)
+            {
+                uint16_t * row = depthData + size_t(y) * this->width;
+                for (int x = 0; x < this->width; ++x)
+                {
+                    const size_t idx = (size_t(tileY) * this->tilesX + (x / TileSize)) * TileSize * TileSize + (y % TileSize) * TileSize + (x % TileSize);
+                    const uint32_t depth = this->zBuffer[idx].load(std::memory_order_relaxed);
+                    row[x] = (depth <= 0xFFFF) ? (uint16_t)depth : 0;
+                }
+            }
+        });
+    }
+
+    const ofShortPixels & DepthRenderer::getDepthPix() const
+    {
+        return this->depthPix;
+    }
+
+    float DepthRenderer::getDepthScale() const
+    {
+        return this->depthScale;
+    }
+
+    int DepthRenderer::getWidth() const
+    {
+        return this->width;
+    }
+
+    int DepthRenderer::getHeight() const
+    {
+        return this->height;
+    }
+
+    void DepthRenderer::allocate(int width, int height)
+    {
+        this->width = std::max(width, 0);
+        this->height = std::max(height, 0);
+        this->tilesX = (this->width + TileSize - 1) / TileSize;
+        this->tilesY = (this->height + TileSize - 1) / TileSize;
+
+        const size_t size = size_t(this->tilesX) * this->tilesY * TileSize * TileSize;
+        if (size != this->zBufferSize)
+        {
+            this->zBuffer.reset(size ? new std::atomic<uint32_t>[size] : nullptr);
+            this->zBufferSize = size;
+        }
+        this->begin();
+    }
+
+    glm::mat4 DepthRenderer::getViewTransform(const glm::mat4 & pose) const
+    {
+        return invertRigid(this->pose) * pose;
+    }
+
+    void DepthRenderer::splat(const glm::vec3 & point)
+    {
+        if (point.z <= 0.0f) return;
+
+        float u;
+        float v;
+        if (this->orthographic)
+        {
+            u = point.x * this->fx + this->ppx;
+            v = point.y * this->fy + this->ppy;
+        }
+        else
+        {
+            u = point.x / point.z * this->fx + this->ppx;
+            v = point.y / point.z * this->fy + this->ppy;
+        }
+
+        const int cx = (int)std::floor(u + 0.5f);
+        const int cy = (int)std::floor(v + 0.5f);
+        const int radius = this->splatRadius;
+        if (cx + radius < 0 || cy + radius < 0 || cx - radius >= this->width || cy - radius >= this->height) return;
+
+        const uint32_t depth = (uint32_t)std::min(point.z / this->depthScale + 0.5f, 4294967040.0f);
+        const int x0 = std::max(cx - radius, 0);
+        const int y0 = std::max(cy - radius, 0);
+        const int x1 = std::min(cx + radius, this->width - 1);
+        const int y1 = std::min(cy + radius, this->height - 1);
+        for (int y = y0; y <= y1; ++y)
+        {
+            const size_t tileRow = size_t(y / TileSize) * this->tilesX;
+            const int rowInTile = (y % TileSize) * TileSize;
+            for (int x = x0; x <= x1; ++x)
+            {
+                atomicMin(this->zBuffer[(tileRow + x / TileSize) * TileSize * TileSize + rowInTile + (x % TileSize)], depth);
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ofPixels.h"
+#include "ofVectorMath.h"
+
+#include "Intrinsics.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ofxRealSense2
+{
+    // Virtual depth camera, renders points from one or more cameras into a new
+    // view by splatting them into a z-buffer on the CPU. The view is either a
+    // perspective camera or an orthographic one, like a top-down height map.
+    // The output is raw depth, like the depth stream, zero where nothing landed.
+    class DepthRenderer
+    {
+    public:
+        DepthRenderer();
+
+        // Poses map view space to world space, the view looks down its z axis.
+        // Depth is stored in units of the scale, like Z16 depth.
+        void setupPerspective(const Intrinsics & intrinsics, const glm::mat4 & pose, float depthScale = 0.001f);
+        // The pose places the center of the image, pixel size is in meters.
+        void setupOrthographic(int width, int height, float pixelSize, const glm::mat4 & pose, float depthScale = 0.001f);
+
+        // Radius in pixels each point covers, to close gaps when the view is denser than the points.
+        void setSplatRadius(int splatRadius);
+
+        // Clears the z-buffer.
+        void begin();
+        // Splats a depth frame, the pose maps its camera space to world space.
+        void addDepth(const uint16_t * depthData, const Intrinsics & intrinsics, float depthScale, const glm::mat4 & pose);
+        void addPoints(const glm::vec3 * points, size_t count, const glm::mat4 & pose);
+        // Resolves the z-buffer into the depth pixels.
+        void end();
+
+        const ofShortPixels & getDepthPix() const;
+        float getDepthScale() const;
+
+        int getWidth() const;
+        int getHeight() const;
+
+    private:
+        void allocate(int width, int height);
+        glm::mat4 getViewTransform(const glm::mat4 & pose) const;
+        void splat(const glm::vec3 & point);
+
+    private:
+        bool orthographic;
+        int width;
+        int height;
+        float fx;
+        float fy;
+        float ppx;
+        float ppy;
+        glm::mat4 pose;
+        float depthScale;
+        int splatRadius;
+
+        // Depth in 8x8 pixel tiles, so neighbouring splats share cache lines.
+        static const int TileSize = 8;
+        int tilesX;
+        int tilesY;
+        std::unique_ptr<std::atomic<uint32_t>[]> zBuffer;
+        size_t zBufferSize;
+
+        ofShortPixels depthPix;
+    };
+}
\ No newline at end of file
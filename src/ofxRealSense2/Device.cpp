@@ -1,22 +1,68 @@
 #include "Device.h"
 
+#include "ColorConverter.h"
+#include "DepthConverter.h"
+
 #include "ofLog.h"
+#include "ofMath.h"
+
+#include <algorithm>
+#include <chrono>
 
 namespace ofxRealSense2
 {
+    namespace
+    {
+        bool isSameProfile(const DeviceCache::Stream & a, const DeviceCache::Stream & b)
+        {
+            return a.stream == b.stream && a.index == b.index && a.format == b.format &&
+                a.width == b.width && a.height == b.height && a.fps == b.fps;
+        }
+    }
+
     Device::Device(rs2::context& context, const rs2::device& device)
-        : pipeline(context)
-        , device(device)
-        , depthWidth(640), depthHeight(360)
-        , depthFrameRef(nullptr)
+        : device(device)
+        , pipeline(context)
+        , running(false)
+        , warmStart(false)
+        , directStartEnabled(false)
+        , depthScale(0.001f)
+        , depthWidth(640), depthHeight(360), depthFps(30)
+        , depthRequest({ 640, 360, 30 })
         , depthEnabled(true)
-        , infraredWidth(640), infraredHeight(360)
+        , depthFrameCount(0)
+        , depthPixFrame(0)
+        , depthTexFrame(0)
+        , rawDepthTexFrame(0)
+        , foregroundTexFrame(0)
+        , surfaceMeshFrame(0)
+        , floatDepthTexFrame(0)
+        , infraredWidth(640), infraredHeight(360), infraredFps(30)
+        , infraredRequest({ 640, 360, 30 })
         , infraredEnabled(false)
-        , colorWidth(640), colorHeight(360)
+        , infraredFrameCount(0)
+        , infraredTexFrame(0)
+        , cleanInfraredFrameCount(0)
+        , cleanInfraredTexFrame(0)
+        , colorWidth(640), colorHeight(360), colorFps(30)
+        , colorRequest({ 640, 360, 30 })
+        , colorFormat(RS2_FORMAT_RGB8)
         , colorEnabled(false)
+        , colorFrameCount(0)
+        , colorTexFrame(0)
         , alignToDepth(RS2_STREAM_DEPTH)
         , alignToColor(RS2_STREAM_COLOR)
-        , running(false)
+        , pointsEnabled(false)
+        , pointsRequested(false)
+        , pointsUnread(false)
+        , pointsFrame(0)
+        , imuGyroFps(0)
+        , imuAccelFps(0)
+        , imuEnabled(false)
+        , imuRunning(false)
+        , imuPipeline(context)
+        , depthImu()
+        , clipVolumeDirty(false)
         , disparityTransform(true)
         , depthTransform(false)
     {
@@ -31,34 +77,355 @@ namespace ofxRealSense2
 
     void Device::startPipeline()
     {
+        std::lock_guard<std::recursive_mutex> lock(this->pipelineMutex);
+        this->prepareStart();
+        this->startStreams();
+    }
+
+    void Device::prepareStart()
+    {
+        std::lock_guard<std::recursive_mutex> lock(this->pipelineMutex);
         if (this->running)
         {
             this->stopPipeline();
         }
 
         auto serialNumber = std::string(this->device.get_info(RS2_CAMERA_INFO_SERIAL_NUMBER));
+        auto firmwareVersion = std::string(this->device.get_info(RS2_CAMERA_INFO_FIRMWARE_VERSION));
+        this->warmStart = this->cache.load(serialNumber, firmwareVersion);
+
         this->config.enable_device(serialNumber);
         this->setupParams();
-        this->profile = this->pipeline.start(this->config);
+    }
+
+    void Device::startStreams()
+    {
+        std::lock_guard<std::recursive_mutex> lock(this->pipelineMutex);
+
+        const auto startTime = std::chrono::steady_clock::now();
+
+        auto serialNumber = std::string(this->device.get_info(RS2_CAMERA_INFO_SERIAL_NUMBER));
+        this->startIntrinsics.clear();
+        this->workerDepthProfile = rs2::stream_profile();
+        const bool direct = this->startProfile(serialNumber);
+
+        if (!this->cache.getDepthScale(this->depthScale))
+        {
+            this->depthScale = this->device.first<rs2::depth_sensor>().get_depth_scale();
+            this->cache.setDepthScale(this->depthScale);
+        }
+        this->cache.save();
+
+        // Option writes go through the queue so parameter changes never block on USB.
+        this->optionQueue.start(this->device.first<rs2::depth_sensor>());
+
+        if (this->imuEnabled)
+        {
+            this->startImu(serialNumber);
+        }
+
+        this->depthStats.clear();
+        this->infraredStats.clear();
+        this->cleanInfraredStats.clear();
         this->startThread();
         this->running = true;
+
+        const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+        ofLogVerbose(__FUNCTION__) << "Device " << serialNumber << " started in " << duration.count() << " ms ("
+            << (this->warmStart ? "warm" : "cold") << " cache, " << (direct ? "sensors opened directly" : "pipeline") << ")";
+    }
+
+    bool Device::startProfile(const std::string & serialNumber)
+    {
+        const auto request = this->getStreamRequest();
+
+        std::vector<DeviceCache::Stream> streams;
+        if (this->cache.getStreams(request, streams) && this->directStartEnabled)
+        {
+            if (this->startSensors(streams))
+            {
+                return true;
+            }
+
+            // The device may be on a different port with other modes, resolve again.
+            ofLogNotice(__FUNCTION__) << "Cached profiles for device " << serialNumber << " failed to start, resolving them again";
+        }
+
+        this->profile = this->pipeline.start(this->config);
+
+        // Remember what the request resolved to, intrinsics are only queried for profiles the cache doesn't have.
+        std::vector<DeviceCache::Stream> resolvedStreams;
+        bool changed = false;
+        for (auto & streamProfile : this->profile.get_streams())
+        {
+            auto videoProfile = streamProfile.as<rs2::video_stream_profile>();
+            if (!videoProfile) continue;
+
+            DeviceCache::Stream stream;
+            stream.stream = videoProfile.stream_type();
+            stream.index = videoProfile.stream_index();
+            stream.format = videoProfile.format();
+            stream.width = videoProfile.width();
+            stream.height = videoProfile.height();
+            stream.fps = videoProfile.fps();
+
+            auto cachedIt = std::find_if(streams.begin(), streams.end(), [&stream](const DeviceCache::Stream & cached)
+            {
+                return isSameProfile(cached, stream);
+            });
+            if (cachedIt != streams.end())
+            {
+                stream.intrinsics = cachedIt->intrinsics;
+            }
+            else
+            {
+                stream.intrinsics = videoProfile.get_intrinsics();
+                changed = true;
+            }
+            resolvedStreams.push_back(stream);
+            this->startIntrinsics.emplace_back(videoProfile.unique_id(), stream.intrinsics);
+        }
+        if (changed || resolvedStreams.size() != streams.size())
+        {
+            this->cache.setStreams(request, resolvedStreams);
+        }
+        return false;
+    }
+
+    bool Device::startSensors(const std::vector<DeviceCache::Stream> & streams)
+    {
+        // Find the cached streams in the profiles the sensors list, grouped by sensor.
+        // Opening them directly skips the pipeline, which would enumerate devices and match the request again.
+        std::vector<rs2::sensor> sensors;
+        std::vector<std::vector<rs2::stream_profile>> sensorProfiles;
+        std::vector<std::pair<int, rs2_intrinsics>> intrinsics;
+        size_t numFound = 0;
+        for (auto & sensor : this->device.query_sensors())
+        {
+            std::vector<rs2::stream_profile> profiles;
+            for (auto & streamProfile : sensor.get_stream_profiles())
+            {
+                auto videoProfile = streamProfile.as<rs2::video_stream_profile>();
+                if (!videoProfile) continue;
+
+                for (const auto & stream : streams)
+                {
+                    if (videoProfile.stream_type() == stream.stream && videoProfile.stream_index() == stream.index &&
+                        videoProfile.format() == stream.format && videoProfile.fps() == stream.fps &&
+                        videoProfile.width() == stream.width && videoProfile.height() == stream.height)
+                    {
+                        profiles.push_back(videoProfile);
+                        intrinsics.emplace_back(videoProfile.unique_id(), stream.intrinsics);
+                        break;
+                    }
+                }
+            }
+
+            if (!profiles.empty())
+            {
+                numFound += profiles.size();
+                sensors.push_back(sensor);
+                sensorProfiles.push_back(profiles);
+            }
+        }
+        if (numFound != streams.size()) return false;
+
+        size_t numOpen = 0;
+        size_t numStarted = 0;
+        try
+        {
+            for (; numOpen < sensors.size(); ++numOpen)
+            {
+                sensors[numOpen].open(sensorProfiles[numOpen]);
+            }
+            for (; numStarted < sensors.size(); ++numStarted)
+            {
+                sensors[numStarted].start(this->syncer);
+            }
+        }
+        catch (rs2::error & e)
+        {
+            ofLogNotice(__FUNCTION__) << "Sensors failed to start: " << e.what();
+            for (size_t i = 0; i < numStarted; ++i)
+            {
+                sensors[i].stop();
+            }
+            for (size_t i = 0; i < numOpen; ++i)
+            {
+                sensors[i].close();
+            }
+            return false;
+        }
+
+        this->sensors = sensors;
+        this->profile = rs2::pipeline_profile();
+        this->startIntrinsics = intrinsics;
+        return true;
+    }
+
+    void Device::stopSensors()
+    {
+        for (auto & sensor : this->sensors)
+        {
+            sensor.stop();
+        }
+        for (auto & sensor : this->sensors)
+        {
+            sensor.close();
+        }
+        this->sensors.clear();
+    }
+
+    bool Device::waitForFrames(rs2::frameset & frameset)
+    {
+        if (this->sensors.empty())
+        {
+            frameset = this->pipeline.wait_for_frames();
+            return true;
+        }
+
+        // A short timeout, so the thread notices when it's stopped, the sensors don't throw on stop like the pipeline does.
+        return this->syncer.try_wait_for_frames(&frameset, 100);
+    }
+
+    void Device::startImu(const std::string & serialNumber)
+    {
+        rs2::config imuConfig;
+        imuConfig.enable_device(serialNumber);
+        imuConfig.enable_stream(RS2_STREAM_GYRO, RS2_FORMAT_MOTION_XYZ32F, this->imuGyroFps);
+        imuConfig.enable_stream(RS2_STREAM_ACCEL, RS2_FORMAT_MOTION_XYZ32F, this->imuAccelFps);
+
+        this->imuRing.clear();
+        this->imuHistory.clear();
+        this->depthImu.valid = false;
+
+        try
+        {
+            // Samples are pushed from the librealsense callback thread as they arrive,
+            // going through frame queues and update() would drop most of them.
+            this->imuPipeline.start(imuConfig, [this](const rs2::frame & frame)
+            {
+                this->pushImuFrame(frame);
+            });
+            this->imuRunning = true;
+        }
+        catch (rs2::error & e)
+        {
+            ofLogWarning(__FUNCTION__) << "Device " << serialNumber << " IMU could not start: " << e.what();
+        }
+    }
+
+    void Device::pushImuFrame(const rs2::frame & frame)
+    {
+        if (auto frameset = frame.as<rs2::frameset>())
+        {
+            for (const auto & subframe : frameset)
+            {
+                this->pushImuFrame(subframe);
+            }
+            return;
+        }
+
+        ImuSample sample;
+        if (ImuSample::fromFrame(frame, sample))
+        {
+            this->imuRing.push(sample);
+        }
+    }
+
+    std::string Device::getStreamRequest() const
+    {
+        // Identifies the enabled streams as the config was set up, cached profiles are only valid for the same request.
+        std::ostringstream request;
+        if (this->depthEnabled)
+        {
+            request << "depth " << this->depthRequest.width << "x" << this->depthRequest.height << "@" << this->depthRequest.fps << ";";
+        }
+        if (this->infraredEnabled)
+        {
+            request << "infrared " << this->infraredRequest.width << "x" << this->infraredRequest.height << "@" << this->infraredRequest.fps << ";";
+        }
+        if (this->colorEnabled)
+        {
+            request << "color " << this->colorRequest.width << "x" << this->colorRequest.height << "@" << this->colorRequest.fps << " " << rs2_format_to_string(this->colorFormat) << ";";
+        }
+        return request.str();
+    }
+
+    rs2::option_range Device::getOptionRange(const rs2::sensor & sensor, rs2_option option)
+    {
+        // Sensor option ranges are queried from the device, keep them with the firmware.
+        const auto key = std::string(sensor.get_info(RS2_CAMERA_INFO_NAME)) + "/" + rs2_option_to_string(option);
+
+        rs2::option_range range;
+        if (!this->cache.getOptionRange(key, range))
+        {
+            range = sensor.get_option_range(option);
+            this->cache.setOptionRange(key, range);
+        }
+        return range;
     }
 
     void Device::stopPipeline()
     {
+        std::lock_guard<std::recursive_mutex> lock(this->pipelineMutex);
         if (!this->running) return;
 
         this->stopThread();
-        this->pipeline.stop();
+        this->optionQueue.stop();
+        if (this->sensors.empty())
+        {
+            this->pipeline.stop();
+        }
+        else
+        {
+            // The thread reads from the sensors, wait for it to leave first.
+            this->waitForThread(false);
+            this->stopSensors();
+        }
+        if (this->imuRunning)
+        {
+            this->imuPipeline.stop();
+            this->imuRunning = false;
+        }
         this->clearParams();
         this->running = false;
     }
 
+    std::future<void> Device::startPipelineAsync()
+    {
+        // Parameters and their listeners belong to the calling thread, only the pipeline starts in the background.
+        this->prepareStart();
+        return std::async(std::launch::async, [this]
+        {
+            this->startStreams();
+        });
+    }
+
+    std::future<void> Device::stopPipelineAsync()
+    {
+        this->clearParams();
+        return std::async(std::launch::async, [this]
+        {
+            this->stopPipeline();
+        });
+    }
+
     bool Device::isRunning() const
     {
         return this->running;
     }
 
+    void Device::enableDirectStart()
+    {
+        this->directStartEnabled = true;
+    }
+
+    void Device::disableDirectStart()
+    {
+        this->directStartEnabled = false;
+    }
+
     void Device::setupParams()
     {
         const auto name = std::string(this->device.get_info(RS2_CAMERA_INFO_NAME));
@@ -73,13 +440,14 @@ namespace ofxRealSense2
             );
 
             rs2::sensor sensor = this->device.query_sensors()[0];
-            rs2::option_range orExposure = sensor.get_option_range(rs2_option::RS2_OPTION_EXPOSURE);
-            rs2::option_range orGain = sensor.get_option_range(rs2_option::RS2_OPTION_GAIN);
+            rs2::option_range orExposure = this->getOptionRange(sensor, rs2_option::RS2_OPTION_EXPOSURE);
+            rs2::option_range orGain = this->getOptionRange(sensor, rs2_option::RS2_OPTION_GAIN);
 
             this->params.add
             (
                 this->autoExposure.set("Auto-exposure", true),
                 this->emitterEnabled.set("Emitter", true),
+                this->emitterOnOff.set("Emitter On/Off", false),
                 this->irExposure.set("IR Exposure", orExposure.def, orExposure.min, orExposure.max)
             );
 
@@ -87,33 +455,28 @@ namespace ofxRealSense2
             {
                 if (!this->running) return;
 
-                auto sensor = this->pipeline.get_active_profile().get_device().first<rs2::depth_sensor>();
-                if (sensor.supports(RS2_OPTION_ENABLE_AUTO_EXPOSURE))
-                {
-                    sensor.set_option(RS2_OPTION_ENABLE_AUTO_EXPOSURE, this->autoExposure ? 1.0f : 0.0f);
-                }
+                this->optionQueue.post(RS2_OPTION_ENABLE_AUTO_EXPOSURE, this->autoExposure ? 1.0f : 0.0f);
             }));
 
             this->eventListeners.push(this->emitterEnabled.newListener([this](bool &)
             {
                 if (!this->running) return;
 
-                auto sensor = this->pipeline.get_active_profile().get_device().first<rs2::depth_sensor>();
-                if (sensor.supports(RS2_OPTION_EMITTER_ENABLED))
-                {
-                    sensor.set_option(RS2_OPTION_EMITTER_ENABLED, this->emitterEnabled ? 1.0f : 0.0f);
-                }
+                this->optionQueue.post(RS2_OPTION_EMITTER_ENABLED, this->emitterEnabled ? 1.0f : 0.0f);
+            }));
+
+            this->eventListeners.push(this->emitterOnOff.newListener([this](bool &)
+            {
+                if (!this->running) return;
+
+                this->optionQueue.post(RS2_OPTION_EMITTER_ON_OFF, this->emitterOnOff ? 1.0f : 0.0f);
             }));
 
             this->eventListeners.push(this->irExposure.newListener([this](int &)
             {
                 if (!this->running) return;
 
-                auto sensor = this->pipeline.get_active_profile().get_device().first<rs2::depth_sensor>();
-                if (sensor.supports(rs2_option::RS2_OPTION_EXPOSURE))
-                {
-                    sensor.set_option(rs2_option::RS2_OPTION_EXPOSURE, (float)this->irExposure);
-                }
+                this->optionQueue.post(rs2_option::RS2_OPTION_EXPOSURE, (float)this->irExposure);
             }));
         }
 
@@ -125,7 +488,8 @@ namespace ofxRealSense2
             this->params.add
             (
                 this->depthMin.set("Min Depth", orMinDist.def, orMinDist.min, orMinDist.max),
-                this->depthMax.set("Max Depth", orMaxDist.def, orMaxDist.min, orMaxDist.max)
+                this->depthMax.set("Max Depth", orMaxDist.def, orMaxDist.min, orMaxDist.max),
+                this->clipPointsToDepth.set("Clip Points To Depth", false)
             );
 
             this->eventListeners.push(this->depthMin.newListener([this](float &)
@@ -256,6 +620,89 @@ namespace ofxRealSense2
                 this->holeFillingFilter.set_option(RS2_OPTION_HOLES_FILL, (float)this->holeFillingMode);
             }));
         }
+
+        // Background model parameters.
+        {
+            this->params.add
+            (
+                this->backgroundEnabled.set("Background", false),
+                this->backgroundFrozen.set("Background Freeze", false),
+                this->backgroundLearningRate.set("Background Learning Rate", 0.01f, 0.0f, 1.0f),
+                this->backgroundThreshold.set("Background Threshold", 0.05f, 0.0f, 1.0f),
+                this->backgroundDeviations.set("Background Deviations", 3.0f, 0.0f, 10.0f)
+            );
+
+            this->eventListeners.push(this->backgroundFrozen.newListener([this](bool &)
+            {
+                this->backgroundModel.setFrozen(this->backgroundFrozen);
+            }));
+        }
+
+        // Blob parameters.
+        {
+            this->params.add
+            (
+                this->blobsEnabled.set("Blobs", false),
+                this->blobMinArea.set("Blob Min Area", 100, 1, 10000),
+                this->blobMaxCount.set("Blob Max Count", 16, 1, 256)
+            );
+        }
+
+        // Region stats parameters.
+        {
+            this->params.add
+            (
+                this->regionStatsEnabled.set("Region Stats", false),
+                this->regionZoneSize.set("Region Zone Size", 16, 0, 64),
+                this->regionMaxDistance.set("Region Max Distance", 10.0f, 1.0f, 20.0f)
+            );
+        }
+
+        // Float depth parameters.
+        {
+            this->params.add
+            (
+                this->floatDepthEnabled.set("Float Depth", false),
+                this->floatDepthNaN.set("Float Depth NaN", false)
+            );
+        }
+
+        // Depth pyramid parameters.
+        {
+            this->params.add
+            (
+                this->pyramidEnabled.set("Depth Pyramid", false),
+                this->pyramidLevels.set("Pyramid Levels", 3, 1, 6),
+                this->pyramidMode.set("Pyramid Mode", DepthPyramid::Min, DepthPyramid::Min, DepthPyramid::Mean)
+            );
+        }
+
+        // Surface mesh parameters.
+        {
+            this->params.add
+            (
+                this->meshEnabled.set("Surface Mesh", false),
+                this->meshDecimation.set("Mesh Decimation", 1, 0, 3),
+                this->meshDiscontinuity.set("Mesh Discontinuity", 0.05f, 0.0f, 0.5f)
+            );
+        }
+
+        // Point normals parameters.
+        {
+            this->params.add
+            (
+                this->pointNormalsEnabled.set("Point Normals", false),
+                this->pointNormalsRadius.set("Normal Radius", 1, 1, 8)
+            );
+        }
+
+        // Occupancy parameters.
+        {
+            this->params.add
+            (
+                this->occupancyEnabled.set("Occupancy", false)
+            );
+        }
     }
 
     void Device::clearParams()
@@ -267,6 +714,8 @@ namespace ofxRealSense2
     {
         this->depthWidth = width;
         this->depthHeight = height;
+        this->depthFps = fps;
+        this->depthRequest = { width, height, fps };
         this->config.enable_stream(RS2_STREAM_DEPTH, this->depthWidth, this->depthHeight, RS2_FORMAT_Z16, fps);
         this->depthPix.allocate(this->depthWidth, this->depthHeight, OF_IMAGE_COLOR);
         this->depthTex.allocate(this->depthWidth, this->depthHeight, GL_RGB);
@@ -290,6 +739,8 @@ namespace ofxRealSense2
     {
         this->infraredWidth = width;
         this->infraredHeight = height;
+        this->infraredFps = fps;
+        this->infraredRequest = { width, height, fps };
         this->config.enable_stream(RS2_STREAM_INFRARED, this->infraredWidth, this->infraredHeight, RS2_FORMAT_Y8, fps);
         this->infraredPix.allocate(this->infraredWidth, this->infraredHeight, OF_IMAGE_GRAYSCALE);
         this->infraredTex.allocate(this->infraredWidth, this->infraredHeight, GL_LUMINANCE);
@@ -301,14 +752,25 @@ namespace ofxRealSense2
         this->config.disable_stream(RS2_STREAM_INFRARED);
         this->infraredPix.clear();
         this->infraredTex.clear();
+        this->cleanInfraredPix.clear();
+        this->cleanInfraredTex.clear();
         this->infraredEnabled = false;
     }
 
-    void Device::enableColor(int width, int height, int fps)
+    void Device::enableColor(int width, int height, int fps, rs2_format format)
     {
+        if (format != RS2_FORMAT_RGB8 && !ColorConverter::isSupported(format, OF_PIXELS_RGB))
+        {
+            ofLogWarning(__FUNCTION__) << "Unsupported color format " << rs2_format_to_string(format) << ", using RGB8";
+            format = RS2_FORMAT_RGB8;
+        }
+
         this->colorWidth = width;
         this->colorHeight = height;
-        this->config.enable_stream(RS2_STREAM_COLOR, this->colorWidth, this->colorHeight, RS2_FORMAT_RGB8, fps);
+        this->colorFps = fps;
+        this->colorRequest = { width, height, fps };
+        this->colorFormat = format;
+        this->config.enable_stream(RS2_STREAM_COLOR, this->colorWidth, this->colorHeight, this->colorFormat, fps);
         this->colorPix.allocate(this->colorWidth, this->colorHeight, OF_IMAGE_COLOR);
         this->colorTex.allocate(this->colorWidth, this->colorHeight, GL_RGB);
         this->colorEnabled = true;
@@ -337,25 +799,80 @@ namespace ofxRealSense2
         this->pointsEnabled = false;
     }
 
+    void Device::enableImu(int gyroFps, int accelFps)
+    {
+        this->imuGyroFps = gyroFps;
+        this->imuAccelFps = accelFps;
+        this->imuEnabled = true;
+    }
+
+    void Device::disableImu()
+    {
+        this->imuEnabled = false;
+    }
+
+    void Device::setClipVolume(const ClipVolume & clipVolume)
+    {
+        std::lock_guard<std::mutex> lock(this->clipMutex);
+        this->clipVolume = clipVolume;
+        this->clipVolumeDirty = true;
+    }
+
+    void Device::clearClipVolume()
+    {
+        this->setClipVolume(ClipVolume());
+    }
+
+    ClipVolume Device::getClipVolume() const
+    {
+        std::lock_guard<std::mutex> lock(this->clipMutex);
+        return this->clipVolume;
+    }
+
+    void Device::relearnBackground()
+    {
+        this->backgroundModel.relearn();
+    }
+
     void Device::threadedFunction()
     {
         while (isThreadRunning())
         {
-            rs2::frameset frameset = this->pipeline.wait_for_frames();
+            rs2::frameset frameset;
+            if (!this->waitForFrames(frameset)) continue;
 
-            //const auto align = static_cast<Align>(this->alignMode.get());
-            if (this->alignMode.get() == Align::Depth)
+            // With the emitter alternating, lit frames feed depth and infrared
+            // and unlit frames feed the clean infrared stream.
+            bool laserOn = true;
+            if (this->emitterOnOff)
+            {
+                rs2::frame stateFrame = frameset.get_depth_frame();
+                if (!stateFrame)
+                {
+                    stateFrame = frameset.get_infrared_frame();
+                }
+                if (stateFrame && stateFrame.supports_frame_metadata(RS2_FRAME_METADATA_FRAME_LASER_POWER_MODE))
+                {
+                    laserOn = stateFrame.get_frame_metadata(RS2_FRAME_METADATA_FRAME_LASER_POWER_MODE) != 0;
+                }
+            }
+
+            // Unlit frames skip the alignment, their depth is dropped and the
+            // infrared comes from the depth imager, already in the depth viewport.
+            const int requestedAlign = this->alignMode;
+            const int alignMode = laserOn ? requestedAlign : (int)Align::None;
+            if (alignMode == Align::Depth)
             {
                 // Align all frames to depth viewport.
                 frameset = this->alignToDepth.process(frameset);
             }
-            else if (this->alignMode.get() == Align::Color)
+            else if (alignMode == Align::Color)
             {
                 // Align all frames to color viewport.
                 frameset = this->alignToColor.process(frameset);
             }
 
-            if (this->depthEnabled)
+            if (this->depthEnabled && laserOn)
             {
                 auto depthFrame = frameset.get_depth_frame();
 
@@ -389,110 +906,483 @@ namespace ofxRealSense2
                     depthFrame = this->depthTransform.process(depthFrame);
                 }
 
-                if (this->pointsEnabled)
+                auto & depthData = this->depthBuffer.getBack();
+                depthData.frame = depthFrame;
+                depthData.metadata.capture(depthFrame);
+                this->depthStats.addFrame(depthData.metadata.timestamp);
+                depthData.stats = this->depthStats;
+
+                // Filters like decimation output their own profile, only query it when it changes.
+                const auto depthProfile = depthFrame.get_profile();
+                if (depthProfile.get() != this->workerDepthProfile.get() || depthProfile.unique_id() != this->workerDepthProfile.unique_id())
+                {
+                    this->workerDepthProfile = depthProfile;
+
+                    // Unfiltered frames carry a profile the device started with, its intrinsics come from the cache.
+                    const int uniqueId = depthProfile.unique_id();
+                    auto knownIt = std::find_if(this->startIntrinsics.begin(), this->startIntrinsics.end(), [uniqueId](const std::pair<int, rs2_intrinsics> & known)
+                    {
+                        return known.first == uniqueId;
+                    });
+                    this->workerDepthIntrinsics = Intrinsics((knownIt != this->startIntrinsics.end()) ? knownIt->second : rs2::video_stream_profile(depthProfile).get_intrinsics());
+                }
+                depthData.intrinsics = this->workerDepthIntrinsics;
+
+                // Read once, the GUI can flip it between the segmentation and the blobs.
+                const bool backgroundEnabled = this->backgroundEnabled;
+                if (backgroundEnabled)
+                {
+                    // Segment directly into the buffer slot, update() swaps it out without copying.
+                    const int width = depthFrame.get_width();
+                    const int height = depthFrame.get_height();
+                    if (depthData.foregroundPix.getWidth() != size_t(width) || depthData.foregroundPix.getHeight() != size_t(height))
+                    {
+                        depthData.foregroundPix.allocate(width, height, OF_IMAGE_GRAYSCALE);
+                    }
+
+                    this->backgroundModel.setLearningRate(this->backgroundLearningRate);
+                    this->backgroundModel.setThreshold(this->backgroundThreshold);
+                    this->backgroundModel.setDeviations(this->backgroundDeviations);
+                    this->backgroundModel.update((const uint16_t *)depthFrame.get_data(), width, height, this->depthScale, depthData.foregroundPix.getData());
+                }
+
+                if (this->blobsEnabled)
+                {
+                    const auto rawDepthData = (const uint16_t *)depthFrame.get_data();
+                    const int width = depthFrame.get_width();
+                    const int height = depthFrame.get_height();
+
+                    // Use the foreground if there is one, otherwise the depth range.
+                    const uint8_t * maskData;
+                    if (backgroundEnabled)
+                    {
+                        maskData = depthData.foregroundPix.getData();
+                    }
+                    else
+                    {
+                        if (this->blobMaskPix.getWidth() != size_t(width) || this->blobMaskPix.getHeight() != size_t(height))
+                        {
+                            this->blobMaskPix.allocate(width, height, OF_IMAGE_GRAYSCALE);
+                        }
+                        const auto minDepth = (uint16_t)ofClamp(this->depthMin / this->depthScale, 1.0f, 65535.0f);
+                        const auto maxDepth = (uint16_t)ofClamp(this->depthMax / this->depthScale, 1.0f, 65535.0f);
+                        BlobFinder::threshold(rawDepthData, size_t(width) * height, minDepth, maxDepth, this->blobMaskPix.getData());
+                        maskData = this->blobMaskPix.getData();
+                    }
+
+                    this->blobFinder.setMinArea(this->blobMinArea);
+                    this->blobFinder.setMaxBlobs(this->blobMaxCount);
+                    this->blobFinder.find(maskData, rawDepthData, width, height, this->depthScale, depthData.blobs);
+                }
+                else
+                {
+                    depthData.blobs.clear();
+                }
+
+                if (this->regionStatsEnabled)
+                {
+                    depthData.regionStats.update((const uint16_t *)depthFrame.get_data(), depthFrame.get_width(), depthFrame.get_height(), this->depthScale, this->regionZoneSize, this->regionMaxDistance);
+                }
+
+                if (this->floatDepthEnabled)
+                {
+                    // Meters straight into the slot, update() swaps them in.
+                    const int width = depthFrame.get_width();
+                    const int height = depthFrame.get_height();
+                    if (depthData.floatDepthPix.getWidth() != size_t(width) || depthData.floatDepthPix.getHeight() != size_t(height))
+                    {
+                        depthData.floatDepthPix.allocate(width, height, OF_IMAGE_GRAYSCALE);
+                    }
+
+                    const float invalidValue = this->floatDepthNaN ? std::numeric_limits<float>::quiet_NaN() : 0.0f;
+                    DepthConverter::toMeters((const uint16_t *)depthFrame.get_data(), size_t(width) * height, this->depthScale, invalidValue, depthData.floatDepthPix.getData());
+                }
+
+                if (this->pyramidEnabled)
+                {
+                    depthData.pyramid.update((const uint16_t *)depthFrame.get_data(), depthFrame.get_width(), depthFrame.get_height(), this->pyramidLevels, (DepthPyramid::Mode)this->pyramidMode.get());
+                }
+
+                if (this->meshEnabled)
                 {
-                    // Generate the pointcloud and texture mappings.
-                    this->points = this->pointCloud.calculate(depthFrame);
+                    this->depthMesh.update((const uint16_t *)depthFrame.get_data(), depthData.intrinsics, this->depthScale, 1 << this->meshDecimation, this->meshDiscontinuity, depthData.mesh);
+                }
+
+                if (this->occupancyEnabled)
+                {
+                    this->occupancyGrid.update((const uint16_t *)depthFrame.get_data(), depthData.intrinsics, this->depthScale);
+                }
 
-                    if (!this->colorEnabled || this->alignMode == Align::Depth)
+                depthData.pointsStaged = false;
+                if (this->pointsEnabled)
+                {
+                    if (this->colorEnabled && this->alignMode != Align::Depth)
+                    {
+                        // Map point cloud to color frame.
+                        depthData.textureFrame = frameset.get_color_frame();
+                    }
+                    else
                     {
                         // Map point cloud to depth frame.
-                        this->pointCloud.map_to(depthFrame);
+                        depthData.textureFrame = depthFrame;
+                    }
+
+                    // Only prepare points ahead of time while the app reads them, see updateFrames().
+                    if (this->pointsRequested)
+                    {
+                        {
+                            std::lock_guard<std::mutex> lock(this->clipMutex);
+                            if (this->clipVolumeDirty)
+                            {
+                                this->workerClipVolume = this->clipVolume;
+                                this->clipVolumeDirty = false;
+                            }
+                        }
+
+                        // Generate the pointcloud and texture mappings.
+                        this->pointCloud.map_to(depthData.textureFrame);
+                        depthData.points = this->pointCloud.calculate(depthFrame);
+                        this->stagePoints(depthData, this->workerClipVolume);
+                        depthData.pointsStaged = true;
                     }
                 }
 
-                this->depthQueue.enqueue(depthFrame);
+                this->depthBuffer.publish();
             }
 
-            if (this->colorEnabled)
+            // Color aligned to depth only comes with lit frames, unaligned frames in between would jump.
+            if (this->colorEnabled && (laserOn || requestedAlign != Align::Depth))
             {
                 auto colorFrame = frameset.get_color_frame();
-
-                if (this->pointsEnabled && this->alignMode != Align::Depth)
+                if (colorFrame)
                 {
-                    // Map point cloud to color frame.
-                    this->pointCloud.map_to(colorFrame);
-                }
+                    auto & colorData = this->colorBuffer.getBack();
+                    colorData.frame = colorFrame;
+                    colorData.metadata.capture(colorFrame);
+
+                    // YUV frames are converted straight into the slot pixels, which update() swaps in.
+                    colorData.converted = false;
+                    const auto format = colorFrame.get_profile().format();
+                    if (format != RS2_FORMAT_RGB8 && ColorConverter::isSupported(format, OF_PIXELS_RGB))
+                    {
+                        const int width = colorFrame.get_width();
+                        const int height = colorFrame.get_height();
+                        if (colorData.pixels.getWidth() != size_t(width) || colorData.pixels.getHeight() != size_t(height) || colorData.pixels.getNumChannels() != 3)
+                        {
+                            colorData.pixels.allocate(width, height, OF_IMAGE_COLOR);
+                        }
+                        ColorConverter::convert((const uint8_t *)colorFrame.get_data(), width, height, colorFrame.get_stride_in_bytes(), format, colorData.pixels.getData(), OF_PIXELS_RGB);
+                        colorData.converted = true;
+                    }
 
-                this->colorQueue.enqueue(colorFrame);
+                    this->colorBuffer.publish();
+                }
             }
 
             if (this->infraredEnabled)
             {
                 auto infraredFrame = frameset.get_infrared_frame();
+                if (infraredFrame)
+                {
+                    // Route the frame itself, the split doesn't copy anything.
+                    auto & buffer = laserOn ? this->infraredBuffer : this->cleanInfraredBuffer;
+                    auto & stats = laserOn ? this->infraredStats : this->cleanInfraredStats;
+
+                    auto & infraredData = buffer.getBack();
+                    infraredData.frame = infraredFrame;
+                    infraredData.metadata.capture(infraredFrame);
+                    stats.addFrame(infraredData.metadata.timestamp);
+                    infraredData.stats = stats;
+                    buffer.publish();
+                }
+            }
+        }
+    }
+
+    void Device::stagePoints(DepthData & depthData, const ClipVolume & clipVolume) const
+    {
+        const auto numPoints = depthData.points.size();
+        const auto vertices = reinterpret_cast<const ofDefaultVertexType*>(depthData.points.get_vertices());
+        const auto texCoords = reinterpret_cast<const ofDefaultTexCoordType*>(depthData.points.get_texture_coordinates());
+
+        // Staging vectors are recycled by the depth buffer, so this only allocates on growth.
+        depthData.vertices.resize(numPoints);
+        depthData.texCoords.resize(numPoints);
+
+        // Normals need the organized grid, so they are estimated before clipping.
+        const rs2::video_frame depthFrame(depthData.frame);
+        const bool normalsEnabled = this->pointNormalsEnabled && depthFrame && numPoints == size_t(depthFrame.get_width()) * depthFrame.get_height();
+        if (normalsEnabled)
+        {
+            depthData.normals.resize(numPoints);
+            NormalEstimator::estimate(vertices, depthFrame.get_width(), depthFrame.get_height(), this->pointNormalsRadius, depthData.normals.data());
+        }
+        else
+        {
+            depthData.normals.clear();
+        }
+
+        const bool clipToDepth = this->clipPointsToDepth;
+        if (!clipToDepth && clipVolume.isEmpty())
+        {
+            std::copy(vertices, vertices + numPoints, depthData.vertices.begin());
+            std::copy(texCoords, texCoords + numPoints, depthData.texCoords.begin());
+            return;
+        }
+
+        // Only keep valid points inside the depth range and clip volume.
+        const float minDepth = clipToDepth ? this->depthMin.get() : 0.0f;
+        const float maxDepth = clipToDepth ? this->depthMax.get() : std::numeric_limits<float>::max();
+        size_t numStaged = 0;
+        for (size_t i = 0; i < numPoints; ++i)
+        {
+            const auto & vertex = vertices[i];
+            if (vertex.z <= 0.0f || vertex.z < minDepth || vertex.z > maxDepth) continue;
+            if (!clipVolume.contains(vertex)) continue;
 
-                this->infraredQueue.enqueue(infraredFrame);
+            depthData.vertices[numStaged] = vertex;
+            depthData.texCoords[numStaged] = texCoords[i];
+            if (normalsEnabled)
+            {
+                depthData.normals[numStaged] = depthData.normals[i];
             }
+            ++numStaged;
+        }
+        depthData.vertices.resize(numStaged);
+        depthData.texCoords.resize(numStaged);
+        if (normalsEnabled)
+        {
+            depthData.normals.resize(numStaged);
         }
     }
 
     void Device::update()
     {
+        this->updateFrames();
+        this->updateEvents();
+    }
+
+    void Device::updateEvents()
+    {
+        // Report the option writes the queue finished.
+        this->optionQueue.takeResults(this->optionResults);
+        for (auto & result : this->optionResults)
+        {
+            if (!result.success)
+            {
+                ofLogWarning(__FUNCTION__) << "Setting " << rs2_option_to_string(result.option) << " failed: " << result.error;
+            }
+            this->optionResultEvent.notify(result);
+        }
+    }
+
+    void Device::updateFrames()
+    {
+        // Only the pixels are copied here, textures and other derived outputs
+        // are computed on first access and reused until the next frame.
+        if (this->imuRunning)
+        {
+            this->updateImu();
+        }
+
         if (this->colorEnabled)
         {
-            rs2::frame frame;
-            if (this->colorQueue.poll_for_frame(&frame))
+            if (this->colorBuffer.consume())
             {
-                auto videoFrame = rs2::video_frame(frame);
-                auto colorData = (uint8_t *)videoFrame.get_data();
+                auto & frameData = this->colorBuffer.getFront();
+                auto videoFrame = rs2::video_frame(frameData.frame);
                 this->colorWidth = videoFrame.get_width();
                 this->colorHeight = videoFrame.get_height();
-                this->colorPix.setFromPixels(colorData, this->colorWidth, this->colorHeight, OF_IMAGE_COLOR);
-                this->colorTex.loadData(colorData, this->colorWidth, this->colorHeight, GL_RGB);
+                if (frameData.converted)
+                {
+                    this->colorPix.swap(frameData.pixels);
+                }
+                else
+                {
+                    auto colorData = (uint8_t *)videoFrame.get_data();
+                    this->colorPix.setFromPixels(colorData, this->colorWidth, this->colorHeight, OF_IMAGE_COLOR);
+                }
+                ++this->colorFrameCount;
+
+                // The pixels are copied, give the frame back to librealsense and keep the metadata.
+                frameData.frame = rs2::frame();
             }
         }
 
         if (this->infraredEnabled)
         {
-            rs2::frame frame;
-            if (this->infraredQueue.poll_for_frame(&frame))
+            if (this->infraredBuffer.consume())
             {
-                auto videoFrame = rs2::video_frame(frame);
+                auto & frameData = this->infraredBuffer.getFront();
+                auto videoFrame = rs2::video_frame(frameData.frame);
                 auto infraredData = (uint8_t *)videoFrame.get_data();
                 this->infraredWidth = videoFrame.get_width();
                 this->infraredHeight = videoFrame.get_height();
                 this->infraredPix.setFromPixels(infraredData, this->infraredWidth, this->infraredHeight, OF_IMAGE_GRAYSCALE);
-                this->infraredTex.loadData(infraredData, this->infraredWidth, this->infraredHeight, GL_LUMINANCE);
+                ++this->infraredFrameCount;
+
+                frameData.frame = rs2::frame();
+            }
+
+            if (this->cleanInfraredBuffer.consume())
+            {
+                auto & frameData = this->cleanInfraredBuffer.getFront();
+                auto videoFrame = rs2::video_frame(frameData.frame);
+                this->cleanInfraredPix.setFromPixels((uint8_t *)videoFrame.get_data(), videoFrame.get_width(), videoFrame.get_height(), OF_IMAGE_GRAYSCALE);
+                ++this->cleanInfraredFrameCount;
+
+                frameData.frame = rs2::frame();
             }
         }
 
         if (this->depthEnabled)
         {
-            rs2::frame frame;
-            if (this->depthQueue.poll_for_frame(&frame))
+            if (this->depthBuffer.consume())
             {
-                auto depthFrame = rs2::depth_frame(frame);
+                auto & depthData = this->depthBuffer.getFront();
+
+                // The demand for points only lapses once staged points go unread for a whole frame,
+                // so a camera running faster than the app doesn't push them back to this thread.
+                if (this->pointsUnread)
+                {
+                    this->pointsRequested = false;
+                }
+                this->pointsUnread = depthData.pointsStaged;
+
+                auto depthFrame = rs2::depth_frame(depthData.frame);
                 auto rawDepthData = (uint16_t *)depthFrame.get_data();
                 this->depthWidth = depthFrame.get_width();
                 this->depthHeight = depthFrame.get_height();
                 this->rawDepthPix.setFromPixels(rawDepthData, this->depthWidth, this->depthHeight, OF_IMAGE_GRAYSCALE);
-                this->rawDepthTex.loadData(rawDepthData, this->depthWidth, this->depthHeight, GL_LUMINANCE);
+                this->depthIntrinsics = depthData.intrinsics;
+
+                if (this->imuRunning)
+                {
+                    this->imuHistory.interpolate(depthData.metadata.timestamp, this->depthImu);
+                }
 
-                auto normalizedDepthFrame = this->colorizer.process(depthFrame);
-                auto normalizedDepthData = (uint8_t *)normalizedDepthFrame.get_data();
-                this->depthPix.setFromPixels(normalizedDepthData, this->depthWidth, this->depthHeight, OF_IMAGE_COLOR);
-                this->depthTex.loadData(normalizedDepthData, this->depthWidth, this->depthHeight, GL_RGB);
+                if (this->backgroundEnabled && depthData.foregroundPix.isAllocated())
+                {
+                    this->foregroundPix.swap(depthData.foregroundPix);
+                }
 
-                // Save a reference to the depth frame to 
-                this->depthFrameRef = std::make_shared<rs2::depth_frame>(depthFrame);
+                this->blobs.swap(depthData.blobs);
 
-                if (this->pointsEnabled)
+                if (this->floatDepthEnabled && depthData.floatDepthPix.isAllocated())
                 {
-                    // Upload point data to the vbo.
-                    auto vertices = this->points.get_vertices();
-                    auto texCoords = this->points.get_texture_coordinates();
-                    ofLogVerbose(__FUNCTION__) << "Uploading " << this->points.size() << " points";
-                    this->pointsMesh.setUsage(GL_STREAM_DRAW);
-                    this->pointsMesh.setMode(OF_PRIMITIVE_POINTS);
-                    this->pointsMesh.getVertices().assign(reinterpret_cast<const ofDefaultVertexType*>(vertices), reinterpret_cast<const ofDefaultVertexType*>(vertices + this->points.size()));
-                    this->pointsMesh.getTexCoords().assign(reinterpret_cast<const ofDefaultTexCoordType*>(texCoords), reinterpret_cast<const ofDefaultTexCoordType*>(texCoords + this->points.size()));
+                    this->floatDepthPix.swap(depthData.floatDepthPix);
                 }
+
+                if (this->regionStatsEnabled)
+                {
+                    this->regionStats.swap(depthData.regionStats);
+                }
+
+                if (this->pyramidEnabled)
+                {
+                    this->depthPyramid.swap(depthData.pyramid);
+                }
+
+                ++this->depthFrameCount;
             }
         }
     }
 
+    void Device::updateImu()
+    {
+        // Drain the ring in batches, the history keeps them for readImuSamples().
+        ImuSample batch[64];
+        size_t numSamples;
+        while ((numSamples = this->imuRing.pop(batch, 64)) > 0)
+        {
+            this->imuHistory.add(batch, numSamples);
+        }
+    }
+
+    bool Device::isStale(uint64_t & outputFrame, uint64_t frameCount)
+    {
+        if (outputFrame == frameCount) return false;
+
+        outputFrame = frameCount;
+        return true;
+    }
+
+    template<typename PixelType>
+    void Device::loadTexture(ofTexture & texture, const ofPixels_<PixelType> & pixels, int glInternalFormat, int glFormat)
+    {
+        if (!pixels.isAllocated()) return;
+
+        if (!texture.isAllocated() || texture.getWidth() != pixels.getWidth() || texture.getHeight() != pixels.getHeight())
+        {
+            texture.allocate(pixels.getWidth(), pixels.getHeight(), glInternalFormat);
+        }
+        texture.loadData(pixels.getData(), pixels.getWidth(), pixels.getHeight(), glFormat);
+    }
+
+    void Device::updatePoints() const
+    {
+        // Let the worker know points are in use, so it prepares the next ones.
+        this->pointsRequested = true;
+
+        if (!this->pointsEnabled || !isStale(this->pointsFrame, this->depthFrameCount)) return;
+
+        this->pointsUnread = false;
+        auto & depthData = this->depthBuffer.getFront();
+        if (!depthData.pointsStaged)
+        {
+            // The worker skipped this frame, generate the points here.
+            std::lock_guard<std::mutex> lock(this->clipMutex);
+            this->lazyPointCloud.map_to(depthData.textureFrame);
+            depthData.points = this->lazyPointCloud.calculate(depthData.frame);
+            this->stagePoints(depthData, this->clipVolume);
+        }
+
+        // Swap the staged point data into the vbo, the old vectors get recycled by the worker.
+        this->points = depthData.points;
+        this->pointsMesh.setUsage(GL_STREAM_DRAW);
+        this->pointsMesh.setMode(OF_PRIMITIVE_POINTS);
+        this->pointsMesh.getVertices().swap(depthData.vertices);
+        this->pointsMesh.getTexCoords().swap(depthData.texCoords);
+        this->pointsMesh.getNormals().swap(depthData.normals);
+        if (this->pointsMesh.getNormals().empty())
+        {
+            this->pointsMesh.disableNormals();
+        }
+        else
+        {
+            this->pointsMesh.enableNormals();
+        }
+    }
+
     const ofPixels& Device::getDepthPix() const
     {
+        if (isStale(this->depthPixFrame, this->depthFrameCount))
+        {
+            // Colored in place with the colorizer settings, processing it would allocate a new frame every time.
+            const rs2::video_frame depthFrame(this->depthBuffer.getFront().frame);
+            if (depthFrame)
+            {
+                const int width = depthFrame.get_width();
+                const int height = depthFrame.get_height();
+                if (this->depthPix.getWidth() != size_t(width) || this->depthPix.getHeight() != size_t(height))
+                {
+                    this->depthPix.allocate(width, height, OF_IMAGE_COLOR);
+                }
+
+                const auto depthData = (const uint16_t *)depthFrame.get_data();
+                if (this->colorizer.get_option(RS2_OPTION_HISTOGRAM_EQUALIZATION_ENABLED))
+                {
+                    this->depthHistogram.resize(DepthConverter::HistogramSize);
+                    DepthConverter::toGrayEqualized(depthData, size_t(width) * height, this->depthHistogram.data(), this->depthPix.getData());
+                }
+                else
+                {
+                    const float minDistance = this->colorizer.get_option(RS2_OPTION_MIN_DISTANCE);
+                    const float maxDistance = this->colorizer.get_option(RS2_OPTION_MAX_DISTANCE);
+                    DepthConverter::toGray(depthData, size_t(width) * height, this->depthScale, minDistance, maxDistance, this->depthPix.getData());
+                }
+            }
+        }
         return this->depthPix;
     }
 
@@ -501,69 +1391,206 @@ namespace ofxRealSense2
         return this->rawDepthPix;
     }
 
+    const ofFloatPixels& Device::getFloatDepthPix() const
+    {
+        return this->floatDepthPix;
+    }
+
     const ofPixels& Device::getInfraredPix() const
     {
         return this->infraredPix;
     }
 
+    const ofPixels& Device::getCleanInfraredPix() const
+    {
+        return this->cleanInfraredPix;
+    }
+
     const ofPixels& Device::getColorPix() const
     {
         return this->colorPix;
     }
 
+    const ofPixels& Device::getForegroundPix() const
+    {
+        return this->foregroundPix;
+    }
+
     const ofTexture& Device::getDepthTex() const
     {
+        if (isStale(this->depthTexFrame, this->depthFrameCount))
+        {
+            loadTexture(this->depthTex, this->getDepthPix(), GL_RGB, GL_RGB);
+        }
         return this->depthTex;
     }
 
     const ofTexture& Device::getRawDepthTex() const
     {
+        if (isStale(this->rawDepthTexFrame, this->depthFrameCount))
+        {
+            loadTexture(this->rawDepthTex, this->rawDepthPix, GL_LUMINANCE16, GL_LUMINANCE);
+        }
         return this->rawDepthTex;
     }
 
+    const ofTexture& Device::getFloatDepthTex() const
+    {
+        if (isStale(this->floatDepthTexFrame, this->depthFrameCount))
+        {
+            loadTexture(this->floatDepthTex, this->floatDepthPix, GL_R32F, GL_RED);
+        }
+        return this->floatDepthTex;
+    }
+
     const ofTexture& Device::getInfraredTex() const
     {
+        if (isStale(this->infraredTexFrame, this->infraredFrameCount))
+        {
+            loadTexture(this->infraredTex, this->infraredPix, GL_LUMINANCE, GL_LUMINANCE);
+        }
         return this->infraredTex;
     }
 
+    const ofTexture& Device::getCleanInfraredTex() const
+    {
+        if (isStale(this->cleanInfraredTexFrame, this->cleanInfraredFrameCount))
+        {
+            loadTexture(this->cleanInfraredTex, this->cleanInfraredPix, GL_LUMINANCE, GL_LUMINANCE);
+        }
+        return this->cleanInfraredTex;
+    }
+
     const ofTexture& Device::getColorTex() const
     {
+        if (isStale(this->colorTexFrame, this->colorFrameCount))
+        {
+            loadTexture(this->colorTex, this->colorPix, GL_RGB, GL_RGB);
+        }
         return this->colorTex;
     }
 
+    const ofTexture& Device::getForegroundTex() const
+    {
+        if (isStale(this->foregroundTexFrame, this->depthFrameCount))
+        {
+            loadTexture(this->foregroundTex, this->foregroundPix, GL_LUMINANCE, GL_LUMINANCE);
+        }
+        return this->foregroundTex;
+    }
+
+    size_t Device::readImuSamples(double since, std::vector<ImuSample> & samples) const
+    {
+        return this->imuHistory.read(since, samples);
+    }
+
+    const ImuFrame& Device::getDepthImu() const
+    {
+        return this->depthImu;
+    }
+
+    const FrameMetadata& Device::getDepthMetadata() const
+    {
+        return this->depthBuffer.getFront().metadata;
+    }
+
+    const FrameMetadata& Device::getInfraredMetadata() const
+    {
+        return this->infraredBuffer.getFront().metadata;
+    }
+
+    const FrameMetadata& Device::getCleanInfraredMetadata() const
+    {
+        return this->cleanInfraredBuffer.getFront().metadata;
+    }
+
+    const StreamStats& Device::getDepthStats() const
+    {
+        return this->depthBuffer.getFront().stats;
+    }
+
+    const StreamStats& Device::getInfraredStats() const
+    {
+        return this->infraredBuffer.getFront().stats;
+    }
+
+    const StreamStats& Device::getCleanInfraredStats() const
+    {
+        return this->cleanInfraredBuffer.getFront().stats;
+    }
+
+    const FrameMetadata& Device::getColorMetadata() const
+    {
+        return this->colorBuffer.getFront().metadata;
+    }
+
+    const std::vector<Blob>& Device::getBlobs() const
+    {
+        return this->blobs;
+    }
+
+    const RegionStats& Device::getRegionStats() const
+    {
+        return this->regionStats;
+    }
+
+    const DepthPyramid& Device::getDepthPyramid() const
+    {
+        return this->depthPyramid;
+    }
+
     const ofVboMesh& Device::getPointsMesh() const
     {
+        this->updatePoints();
         return this->pointsMesh;
     }
 
     const size_t Device::getNumPoints() const
     {
-        return this->points.size();
+        this->updatePoints();
+        return this->pointsMesh.getNumVertices();
     }
 
-    float Device::getDistance(int x, int y) const
+    const ofVboMesh& Device::getSurfaceMesh() const
     {
-        if (this->depthFrameRef)
+        if (this->meshEnabled && isStale(this->surfaceMeshFrame, this->depthFrameCount))
         {
-            return this->depthFrameRef->get_distance(x, y);
+            // The old buffers go back to the worker, so the mesh only allocates on growth.
+            auto & mesh = this->depthBuffer.getFront().mesh;
+            this->surfaceMesh.setUsage(GL_STREAM_DRAW);
+            this->surfaceMesh.setMode(OF_PRIMITIVE_TRIANGLES);
+            this->surfaceMesh.getVertices().swap(mesh.getVertices());
+            this->surfaceMesh.getTexCoords().swap(mesh.getTexCoords());
+            this->surfaceMesh.getIndices().swap(mesh.getIndices());
         }
-        return 0.0f;
+        return this->surfaceMesh;
+    }
+
+    OccupancyGrid& Device::getOccupancyGrid()
+    {
+        return this->occupancyGrid;
+    }
+
+    float Device::getDistance(int x, int y) const
+    {
+        const glm::vec2 pixel(x, y);
+        float distance;
+        this->getDistances(&pixel, 1, &distance);
+        return distance;
     }
 
     ofDefaultVertexType Device::getWorldPosition(int x, int y) const
     {
-        int idx = y * this->getDepthTex().getWidth() + x;
-        if (idx < this->points.size())
-        {
-            auto vertices = this->points.get_vertices();
-            return ofDefaultVertexType(vertices[idx].x, vertices[idx].y, vertices[idx].z);
-        }
-        return ofDefaultVertexType();
+        const glm::vec2 pixel(x, y);
+        glm::vec3 position;
+        this->getWorldPositions(&pixel, 1, &position);
+        return position;
     }
 
     ofDefaultTexCoordType Device::getTexCoord(int x, int y) const
     {
-        int idx = y * this->getDepthTex().getWidth() + x;
+        this->updatePoints();
+        int idx = y * this->rawDepthPix.getWidth() + x;
         if (idx < this->points.size())
         {
             auto texCoords = this->points.get_texture_coordinates();
@@ -572,6 +1599,73 @@ namespace ofxRealSense2
         return ofDefaultTexCoordType();
     }
 
+    void Device::getDistances(const glm::vec2 * pixels, size_t count, float * distances) const
+    {
+        this->depthIntrinsics.deproject(pixels, count, this->rawDepthPix.getData(), this->depthScale, nullptr, distances);
+    }
+
+    void Device::getDistances(const std::vector<glm::vec2> & pixels, std::vector<float> & distances) const
+    {
+        distances.resize(pixels.size());
+        this->getDistances(pixels.data(), pixels.size(), distances.data());
+    }
+
+    void Device::getWorldPositions(const glm::vec2 * pixels, size_t count, glm::vec3 * positions, float * distances) const
+    {
+        this->depthIntrinsics.deproject(pixels, count, this->rawDepthPix.getData(), this->depthScale, positions, distances);
+    }
+
+    void Device::getWorldPositions(const std::vector<glm::vec2> & pixels, std::vector<glm::vec3> & positions) const
+    {
+        positions.resize(pixels.size());
+        this->getWorldPositions(pixels.data(), pixels.size(), positions.data());
+    }
+
+    const DeviceCache & Device::getCache() const
+    {
+        return this->cache;
+    }
+
+    bool Device::pollOption(rs2_option option)
+    {
+        try
+        {
+            if (this->pollSensors.empty())
+            {
+                this->pollSensors = this->device.query_sensors();
+            }
+
+            for (const auto & sensor : this->pollSensors)
+            {
+                if (sensor.supports(option))
+                {
+                    this->optionMonitor.record(option, sensor.get_option(option));
+                    return true;
+                }
+            }
+        }
+        catch (rs2::error & e)
+        {
+            ofLogVerbose(__FUNCTION__) << "Polling " << rs2_option_to_string(option) << " failed: " << e.what();
+        }
+        return false;
+    }
+
+    const OptionMonitor & Device::getOptionMonitor() const
+    {
+        return this->optionMonitor;
+    }
+
+    const Intrinsics & Device::getDepthIntrinsics() const
+    {
+        return this->depthIntrinsics;
+    }
+
+    float Device::getDepthScale() const
+    {
+        return this->depthScale;
+    }
+
     const rs2::device& Device::getNativeDevice() const
     {
         return this->device;
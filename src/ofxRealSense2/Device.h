@@ -8,6 +8,26 @@
 #include "ofThread.h"
 #include "ofVboMesh.h"
 
+#include <future>
+
+#include "BackgroundModel.h"
+#include "BlobFinder.h"
+#include "ClipVolume.h"
+#include "DepthMesh.h"
+#include "DepthPyramid.h"
+#include "DeviceCache.h"
+#include "FrameMetadata.h"
+#include "Imu.h"
+#include "Intrinsics.h"
+#include "NormalEstimator.h"
+#include "OccupancyGrid.h"
+#include "OptionMonitor.h"
+#include "OptionQueue.h"
+#include "RegionStats.h"
+#include "SpscRing.h"
+#include "StreamStats.h"
+#include "TripleBuffer.h"
+
 namespace ofxRealSense2
 {
     class Device
@@ -26,8 +46,18 @@ namespace ofxRealSense2
 
         void startPipeline();
         void stopPipeline();
+
+        // Start or stop on a background thread, the futures rethrow any error.
+        std::future<void> startPipelineAsync();
+        std::future<void> stopPipelineAsync();
         bool isRunning() const;
 
+        // Warm starts open the cached profiles on the sensors directly, skipping the pipeline's
+        // device enumeration and request matching. The native pipeline isn't started and the
+        // native profile is empty then. Off by default, takes effect on the next start.
+        void enableDirectStart();
+        void disableDirectStart();
+
         void setupParams();
         void clearParams();
 
@@ -37,47 +67,127 @@ namespace ofxRealSense2
         void enableInfrared(int width = 640, int height = 360, int fps = 30);
         void disableInfrared();
 
-        void enableColor(int width = 640, int height = 360, int fps = 30);
+        // YUYV or UYVY take less USB bandwidth than RGB8, they are converted to RGB on the worker thread.
+        void enableColor(int width = 640, int height = 360, int fps = 30, rs2_format format = RS2_FORMAT_RGB8);
         void disableColor();
 
         void enablePoints();
         void disablePoints();
 
+        // Gyro and accelerometer run on their own pipeline, a rate of 0 picks the device default.
+        void enableImu(int gyroFps = 0, int accelFps = 0);
+        void disableImu();
+
+        void setClipVolume(const ClipVolume & clipVolume);
+        void clearClipVolume();
+        // A copy, the volume can be set from another thread.
+        ClipVolume getClipVolume() const;
+
+        void relearnBackground();
+
         void threadedFunction() override;
+
+        // Calls updateFrames() then updateEvents().
         void update();
+        // Stages the latest frames without touching GL, so it can run off the main thread.
+        void updateFrames();
+        // Notifies the events gathered since the last call, on the calling thread.
+        void updateEvents();
 
         const ofPixels& getDepthPix() const;
         const ofShortPixels& getRawDepthPix() const;
+        // Depth in meters, when float depth is enabled.
+        const ofFloatPixels& getFloatDepthPix() const;
         const ofPixels& getInfraredPix() const;
+        // Infrared frames without the projector pattern, when the emitter alternates.
+        const ofPixels& getCleanInfraredPix() const;
         const ofPixels& getColorPix() const;
+        const ofPixels& getForegroundPix() const;
 
         const ofTexture& getDepthTex() const;
         const ofTexture& getRawDepthTex() const;
+        const ofTexture& getFloatDepthTex() const;
         const ofTexture& getInfraredTex() const;
+        const ofTexture& getCleanInfraredTex() const;
         const ofTexture& getColorTex() const;
+        const ofTexture& getForegroundTex() const;
+
+        // Replaces the output with the IMU samples newer than the timestamp (ms), oldest first.
+        size_t readImuSamples(double since, std::vector<ImuSample> & samples) const;
+        // IMU values interpolated at the timestamp of the current depth frame.
+        const ImuFrame& getDepthImu() const;
+
+        // Metadata of the current frames, captured when they arrived.
+        const FrameMetadata& getDepthMetadata() const;
+        const FrameMetadata& getInfraredMetadata() const;
+        const FrameMetadata& getCleanInfraredMetadata() const;
+        const FrameMetadata& getColorMetadata() const;
+
+        // Throughput of the depth, lit and clean infrared streams. With the emitter
+        // alternating, depth only comes from lit frames.
+        const StreamStats& getDepthStats() const;
+        const StreamStats& getInfraredStats() const;
+        const StreamStats& getCleanInfraredStats() const;
+
+        const std::vector<Blob>& getBlobs() const;
+        const RegionStats& getRegionStats() const;
+        const DepthPyramid& getDepthPyramid() const;
 
         const ofVboMesh& getPointsMesh() const;
         const size_t getNumPoints() const;
 
+        // Triangulated depth surface, in meters in depth camera space. Culled
+        // triangles are collapsed to a point, so the index count stays fixed.
+        const ofVboMesh& getSurfaceMesh() const;
+
+        // Fed from the worker thread while enabled, set it up before enabling.
+        OccupancyGrid& getOccupancyGrid();
+
         float getDistance(int x, int y) const;
         ofDefaultVertexType getWorldPosition(int x, int y) const;
         ofDefaultTexCoordType getTexCoord(int x, int y) const;
 
+        // Batched queries on the latest depth frame, deprojected with its cached intrinsics.
+        // These work whether points are enabled or not.
+        void getDistances(const glm::vec2 * pixels, size_t count, float * distances) const;
+        void getDistances(const std::vector<glm::vec2> & pixels, std::vector<float> & distances) const;
+        void getWorldPositions(const glm::vec2 * pixels, size_t count, glm::vec3 * positions, float * distances = nullptr) const;
+        void getWorldPositions(const std::vector<glm::vec2> & pixels, std::vector<glm::vec3> & positions) const;
+
+        // Stream profiles, intrinsics and option ranges the device started with.
+        const DeviceCache & getCache() const;
+
+        // Reads the option from the first sensor that has it into the option monitor,
+        // called from the Context poller thread.
+        bool pollOption(rs2_option option);
+        // Polled option values, safe to read from any thread.
+        const OptionMonitor & getOptionMonitor() const;
+
+        const Intrinsics & getDepthIntrinsics() const;
+        float getDepthScale() const;
+
         const rs2::device& getNativeDevice() const;
+        // Not started, and the profile empty, after a direct start, see enableDirectStart().
         const rs2::pipeline& getNativePipeline() const;
         const rs2::pipeline_profile& getNativeProfile() const;
 
     public:
+        // Notified from update() once a sensor option write is done, successful or not.
+        ofEvent<OptionResult> optionResultEvent;
+
         ofParameterGroup params;
 
         ofParameter<int> alignMode;
 
         ofParameter<bool> autoExposure;
         ofParameter<bool> emitterEnabled;
+        // Alternates the emitter every frame, splitting infrared into lit and clean streams.
+        ofParameter<bool> emitterOnOff;
         ofParameter<int> irExposure;
 
         ofParameter<float> depthMin;
         ofParameter<float> depthMax;
+        ofParameter<bool> clipPointsToDepth;
 
         ofParameter<bool> decimateEnabled;
         ofParameter<int> decimateMagnitude;
@@ -98,46 +208,230 @@ namespace ofxRealSense2
         ofParameter<bool> holeFillingEnabled;
         ofParameter<int> holeFillingMode;
 
+        ofParameter<bool> backgroundEnabled;
+        ofParameter<bool> backgroundFrozen;
+        ofParameter<float> backgroundLearningRate;
+        ofParameter<float> backgroundThreshold;
+        ofParameter<float> backgroundDeviations;
+
+        ofParameter<bool> blobsEnabled;
+        ofParameter<int> blobMinArea;
+        ofParameter<int> blobMaxCount;
+
+        ofParameter<bool> regionStatsEnabled;
+        ofParameter<int> regionZoneSize;
+        ofParameter<float> regionMaxDistance;
+
+        ofParameter<bool> floatDepthEnabled;
+        // Missing depth is NaN instead of zero.
+        ofParameter<bool> floatDepthNaN;
+
+        ofParameter<bool> pyramidEnabled;
+        ofParameter<int> pyramidLevels;
+        // Min, median, or mean, see DepthPyramid::Mode.
+        ofParameter<int> pyramidMode;
+
+        ofParameter<bool> meshEnabled;
+        // Samples every 2^n depth pixels.
+        ofParameter<int> meshDecimation;
+        // Largest depth jump within a triangle, as a fraction of its distance.
+        ofParameter<float> meshDiscontinuity;
+
+        // Adds normals to the points mesh.
+        ofParameter<bool> pointNormalsEnabled;
+        ofParameter<int> pointNormalsRadius;
+
+        // Accumulates depth frames into the occupancy grid.
+        ofParameter<bool> occupancyEnabled;
+
+    private:
+        // Depth data produced on the worker thread, handed to update() as a unit.
+        struct DepthData
+        {
+            rs2::frame frame;
+            FrameMetadata metadata;
+            StreamStats stats;
+            Intrinsics intrinsics;
+            rs2::frame textureFrame;
+            rs2::points points;
+            bool pointsStaged;
+            std::vector<ofDefaultVertexType> vertices;
+            std::vector<ofDefaultTexCoordType> texCoords;
+            std::vector<ofDefaultNormalType> normals;
+            ofPixels foregroundPix;
+            ofFloatPixels floatDepthPix;
+            std::vector<Blob> blobs;
+            RegionStats regionStats;
+            DepthPyramid pyramid;
+            ofMesh mesh;
+        };
+
+        // What a stream was enabled with. The stream sizes follow the frames, which filters and alignment change.
+        struct StreamRequest
+        {
+            int width;
+            int height;
+            int fps;
+        };
+
+        // Color or infrared frame with its metadata, the frame is released once its pixels are copied.
+        struct FrameData
+        {
+            rs2::frame frame;
+            FrameMetadata metadata;
+            StreamStats stats;
+            // Converted on the worker, when the stream isn't RGB.
+            ofPixels pixels;
+            bool converted;
+        };
+
+        // Loads the cache and builds the parameters, on the thread that starts the device.
+        void prepareStart();
+        // Starts the pipeline and the device thread, may run in the background.
+        void startStreams();
+        // Returns true if the cached profiles were opened on the sensors, false if the pipeline started.
+        bool startProfile(const std::string & serialNumber);
+        // Opens the cached profiles on the sensors directly, without the pipeline.
+        bool startSensors(const std::vector<DeviceCache::Stream> & streams);
+        void stopSensors();
+        bool waitForFrames(rs2::frameset & frameset);
+        void startImu(const std::string & serialNumber);
+        void pushImuFrame(const rs2::frame & frame);
+        void updateImu();
+        std::string getStreamRequest() const;
+        rs2::option_range getOptionRange(const rs2::sensor & sensor, rs2_option option);
+
+        void stagePoints(DepthData & depthData, const ClipVolume & clipVolume) const;
+        void updatePoints() const;
+
+        // Marks an output as computed for the current frame, returns true if it was out of date.
+        static bool isStale(uint64_t & outputFrame, uint64_t frameCount);
+
+        template<typename PixelType>
+        static void loadTexture(ofTexture & texture, const ofPixels_<PixelType> & pixels, int glInternalFormat, int glFormat);
+
     private:
         rs2::device device;
         rs2::config config;
         rs2::pipeline pipeline;
         rs2::pipeline_profile profile;
-        rs2::colorizer colorizer;
-
-        bool running;
+        // Sensors opened from cached profiles, the pipeline isn't started then.
+        std::vector<rs2::sensor> sensors;
+        rs2::syncer syncer;
+        mutable rs2::colorizer colorizer;
+
+        std::atomic<bool> running;
+        std::recursive_mutex pipelineMutex;
+        DeviceCache cache;
+        bool warmStart;
+        bool directStartEnabled;
+        OptionQueue optionQueue;
+        std::vector<OptionResult> optionResults;
+        OptionMonitor optionMonitor;
+        std::vector<rs2::sensor> pollSensors;
+        float depthScale;
 
         int depthWidth;
         int depthHeight;
+        int depthFps;
+        StreamRequest depthRequest;
         bool depthEnabled;
-        rs2::frame_queue depthQueue;
-        std::shared_ptr<rs2::depth_frame> depthFrameRef;
-        ofPixels depthPix;
+        mutable TripleBuffer<DepthData> depthBuffer;
+        uint64_t depthFrameCount;
+        mutable ofPixels depthPix;
+        mutable uint64_t depthPixFrame;
+        mutable std::vector<uint32_t> depthHistogram;
         ofShortPixels rawDepthPix;
-        ofTexture depthTex;
-        ofTexture rawDepthTex;
+        mutable ofTexture depthTex;
+        mutable uint64_t depthTexFrame;
+        mutable ofTexture rawDepthTex;
+        mutable uint64_t rawDepthTexFrame;
+        Intrinsics depthIntrinsics;
+        rs2::stream_profile workerDepthProfile;
+        // Intrinsics of the profiles the device started with by unique id, from the cache when it had them.
+        std::vector<std::pair<int, rs2_intrinsics>> startIntrinsics;
+        Intrinsics workerDepthIntrinsics;
+        StreamStats depthStats;
+
+        BackgroundModel backgroundModel;
+        ofPixels foregroundPix;
+        mutable ofTexture foregroundTex;
+        mutable uint64_t foregroundTexFrame;
+
+        BlobFinder blobFinder;
+        ofPixels blobMaskPix;
+        std::vector<Blob> blobs;
+
+        RegionStats regionStats;
+        DepthPyramid depthPyramid;
+
+        DepthMesh depthMesh;
+        mutable ofVboMesh surfaceMesh;
+        mutable uint64_t surfaceMeshFrame;
+
+        OccupancyGrid occupancyGrid;
+
+        ofFloatPixels floatDepthPix;
+        mutable ofTexture floatDepthTex;
+        mutable uint64_t floatDepthTexFrame;
    
         int infraredWidth;
         int infraredHeight;
+        int infraredFps;
+        StreamRequest infraredRequest;
         bool infraredEnabled;
-        rs2::frame_queue infraredQueue;
+        TripleBuffer<FrameData> infraredBuffer;
+        uint64_t infraredFrameCount;
         ofPixels infraredPix;
-        ofTexture infraredTex;
+        mutable ofTexture infraredTex;
+        mutable uint64_t infraredTexFrame;
+        StreamStats infraredStats;
+
+        TripleBuffer<FrameData> cleanInfraredBuffer;
+        uint64_t cleanInfraredFrameCount;
+        ofPixels cleanInfraredPix;
+        mutable ofTexture cleanInfraredTex;
+        mutable uint64_t cleanInfraredTexFrame;
+        StreamStats cleanInfraredStats;
 
         int colorWidth;
         int colorHeight;
+        int colorFps;
+        StreamRequest colorRequest;
+        rs2_format colorFormat;
         bool colorEnabled;
-        rs2::frame_queue colorQueue;
+        TripleBuffer<FrameData> colorBuffer;
+        uint64_t colorFrameCount;
         ofPixels colorPix;
-        ofTexture colorTex;
+        mutable ofTexture colorTex;
+        mutable uint64_t colorTexFrame;
 
         rs2::align alignToDepth;
         rs2::align alignToColor;
 
         rs2::pointcloud pointCloud;
-        rs2::points points;
+        mutable rs2::pointcloud lazyPointCloud;
+        mutable rs2::points points;
         bool pointsEnabled;
-        ofVboMesh pointsMesh;
+        mutable std::atomic<bool> pointsRequested;
+        // The current frame came with staged points that weren't read yet.
+        mutable bool pointsUnread;
+        mutable ofVboMesh pointsMesh;
+        mutable uint64_t pointsFrame;
+
+        int imuGyroFps;
+        int imuAccelFps;
+        bool imuEnabled;
+        std::atomic<bool> imuRunning;
+        rs2::pipeline imuPipeline;
+        SpscRing<ImuSample, 2048> imuRing;
+        ImuHistory imuHistory;
+        ImuFrame depthImu;
+
+        ClipVolume clipVolume;
+        ClipVolume workerClipVolume;
+        bool clipVolumeDirty;
+        mutable std::mutex clipMutex;
 
         rs2::decimation_filter decimationFilter;
         rs2::disparity_transform disparityTransform;
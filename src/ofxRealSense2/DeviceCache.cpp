@@ -0,0 +1,205 @@
+#include "DeviceCache.h"
+
+#include "ofFileUtils.h"
+#include "ofJson.h"
+#include "ofLog.h"
+
+namespace ofxRealSense2
+{
+    namespace
+    {
+        std::string cacheDirectory = "ofxRealSense2";
+    }
+
+    DeviceCache::DeviceCache()
+        : dirty(false)
+        , depthScale(0.0f)
+    {
+
+    }
+
+    void DeviceCache::setDirectory(const std::string & directory)
+    {
+        cacheDirectory = directory;
+    }
+
+    const std::string & DeviceCache::getDirectory()
+    {
+        return cacheDirectory;
+    }
+
+    bool DeviceCache::load(const std::string & serialNumber, const std::string & firmwareVersion)
+    {
+        this->clear();
+        this->serialNumber = serialNumber;
+        this->firmwareVersion = firmwareVersion;
+
+        if (cacheDirectory.empty() || !ofFile::doesFileExist(this->getPath())) return false;
+
+        try
+        {
+            auto json = ofLoadJson(this->getPath());
+            if (!json.is_object() || json.value("firmware", "") != firmwareVersion)
+            {
+                ofLogNotice(__FUNCTION__) << "Cache for device " << serialNumber << " is out of date, ignoring it";
+                this->dirty = true;
+                return false;
+            }
+
+            this->request = json.value("request", "");
+            for (auto & jsonStream : json["streams"])
+            {
+                Stream stream;
+                stream.stream = (rs2_stream)jsonStream["stream"].get<int>();
+                stream.index = jsonStream["index"];
+                stream.format = (rs2_format)jsonStream["format"].get<int>();
+                stream.width = jsonStream["width"];
+                stream.height = jsonStream["height"];
+                stream.fps = jsonStream["fps"];
+
+                auto & jsonIntrinsics = jsonStream["intrinsics"];
+                stream.intrinsics.width = jsonIntrinsics["width"];
+                stream.intrinsics.height = jsonIntrinsics["height"];
+                stream.intrinsics.ppx = jsonIntrinsics["ppx"];
+                stream.intrinsics.ppy = jsonIntrinsics["ppy"];
+                stream.intrinsics.fx = jsonIntrinsics["fx"];
+                stream.intrinsics.fy = jsonIntrinsics["fy"];
+                stream.intrinsics.model = (rs2_distortion)jsonIntrinsics["model"].get<int>();
+                for (int i = 0; i < 5; ++i)
+                {
+                    stream.intrinsics.coeffs[i] = jsonIntrinsics["coeffs"][i];
+                }
+                this->streams.push_back(stream);
+            }
+
+            this->depthScale = json.value("depthScale", 0.0f);
+
+            for (auto & item : json["options"].items())
+            {
+                auto & values = item.value();
+                this->optionRanges[item.key()] = { values[0], values[1], values[2], values[3] };
+            }
+        }
+        catch (std::exception & e)
+        {
+            ofLogWarning(__FUNCTION__) << "Could not read cache for device " << serialNumber << ": " << e.what();
+            this->clear();
+            this->serialNumber = serialNumber;
+            this->firmwareVersion = firmwareVersion;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool DeviceCache::save()
+    {
+        if (!this->dirty || cacheDirectory.empty() || this->serialNumber.empty()) return false;
+
+        ofJson json;
+        json["firmware"] = this->firmwareVersion;
+        json["request"] = this->request;
+
+        json["streams"] = ofJson::array();
+        for (const auto & stream : this->streams)
+        {
+            ofJson jsonStream;
+            jsonStream["stream"] = (int)stream.stream;
+            jsonStream["index"] = stream.index;
+            jsonStream["format"] = (int)stream.format;
+            jsonStream["width"] = stream.width;
+            jsonStream["height"] = stream.height;
+            jsonStream["fps"] = stream.fps;
+
+            ofJson & jsonIntrinsics = jsonStream["intrinsics"];
+            jsonIntrinsics["width"] = stream.intrinsics.width;
+            jsonIntrinsics["height"] = stream.intrinsics.height;
+            jsonIntrinsics["ppx"] = stream.intrinsics.ppx;
+            jsonIntrinsics["ppy"] = stream.intrinsics.ppy;
+            jsonIntrinsics["fx"] = stream.intrinsics.fx;
+            jsonIntrinsics["fy"] = stream.intrinsics.fy;
+            jsonIntrinsics["model"] = (int)stream.intrinsics.model;
+            jsonIntrinsics["coeffs"] = std::vector<float>(stream.intrinsics.coeffs, stream.intrinsics.coeffs + 5);
+
+            json["streams"].push_back(jsonStream);
+        }
+
+        json["depthScale"] = this->depthScale;
+
+        json["options"] = ofJson::object();
+        for (const auto & it : this->optionRanges)
+        {
+            json["options"][it.first] = { it.second.min, it.second.max, it.second.def, it.second.step };
+        }
+
+        ofDirectory::createDirectory(cacheDirectory, true, true);
+        if (!ofSavePrettyJson(this->getPath(), json))
+        {
+            ofLogWarning(__FUNCTION__) << "Could not save cache for device " << this->serialNumber;
+            return false;
+        }
+
+        this->dirty = false;
+        return true;
+    }
+
+    void DeviceCache::clear()
+    {
+        this->serialNumber.clear();
+        this->firmwareVersion.clear();
+        this->dirty = false;
+        this->request.clear();
+        this->streams.clear();
+        this->depthScale = 0.0f;
+        this->optionRanges.clear();
+    }
+
+    bool DeviceCache::getStreams(const std::string & request, std::vector<Stream> & streams) const
+    {
+        if (this->streams.empty() || this->request != request) return false;
+
+        streams = this->streams;
+        return true;
+    }
+
+    void DeviceCache::setStreams(const std::string & request, const std::vector<Stream> & streams)
+    {
+        this->request = request;
+        this->streams = streams;
+        this->dirty = true;
+    }
+
+    bool DeviceCache::getDepthScale(float & depthScale) const
+    {
+        if (this->depthScale <= 0.0f) return false;
+
+        depthScale = this->depthScale;
+        return true;
+    }
+
+    void DeviceCache::setDepthScale(float depthScale)
+    {
+        this->depthScale = depthScale;
+        this->dirty = true;
+    }
+
+    bool DeviceCache::getOptionRange(const std::string & key, rs2::option_range & range) const
+    {
+        auto it = this->optionRanges.find(key);
+        if (it == this->optionRanges.end()) return false;
+
+        range = it->second;
+        return true;
+    }
+
+    void DeviceCache::setOptionRange(const std::string & key, const rs2::option_range & range)
+    {
+        this->optionRanges[key] = range;
+        this->dirty = true;
+    }
+
+    std::string DeviceCache::getPath() const
+    {
+        return ofFilePath::join(cacheDirectory, this->serialNumber + ".json");
+    }
+}
\ No newline at end of file
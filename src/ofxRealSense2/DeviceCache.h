@@ -0,0 +1,64 @@
+#pragma once
+
+#include "librealsense2/rs.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ofxRealSense2
+{
+    // Device details that take USB round trips to query: resolved stream profiles,
+    // their intrinsics, the depth scale, and option ranges. Entries
+    // are persisted to disk per serial number and dropped when the firmware changes,
+    // so warm starts can pin the exact profiles and skip the queries.
+    class DeviceCache
+    {
+    public:
+        struct Stream
+        {
+            rs2_stream stream;
+            int index;
+            rs2_format format;
+            int width;
+            int height;
+            int fps;
+            rs2_intrinsics intrinsics;
+        };
+
+        DeviceCache();
+
+        // Folder the cache files are saved in, relative to the data path. Empty disables persistence.
+        static void setDirectory(const std::string & directory);
+        static const std::string & getDirectory();
+
+        // Loads the saved entry, returns false if there is none or it was saved by another firmware.
+        bool load(const std::string & serialNumber, const std::string & firmwareVersion);
+        // Saves the entry if anything changed since it was loaded.
+        bool save();
+        void clear();
+
+        // Stream profiles resolved for a stream request, see Device::startPipeline().
+        bool getStreams(const std::string & request, std::vector<Stream> & streams) const;
+        void setStreams(const std::string & request, const std::vector<Stream> & streams);
+
+        bool getDepthScale(float & depthScale) const;
+        void setDepthScale(float depthScale);
+
+        bool getOptionRange(const std::string & key, rs2::option_range & range) const;
+        void setOptionRange(const std::string & key, const rs2::option_range & range);
+
+    private:
+        std::string getPath() const;
+
+    private:
+        std::string serialNumber;
+        std::string firmwareVersion;
+        bool dirty;
+
+        std::string request;
+        std::vector<Stream> streams;
+        float depthScale;
+        std::map<std::string, rs2::option_range> optionRanges;
+    };
+}
\ No newline at end of file
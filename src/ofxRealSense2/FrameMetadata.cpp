@@ -0,0 +1,54 @@
+#include "FrameMetadata.h"
+
+namespace ofxRealSense2
+{
+    static_assert(RS2_FRAME_METADATA_COUNT <= 64, "FrameMetadata supported fields don't fit in the mask");
+
+    FrameMetadata::FrameMetadata()
+    {
+        this->clear();
+    }
+
+    void FrameMetadata::capture(const rs2::frame & frame)
+    {
+        this->valid = true;
+        this->frameNumber = frame.get_frame_number();
+        this->timestamp = frame.get_timestamp();
+        this->timestampDomain = frame.get_frame_timestamp_domain();
+
+        this->supportedFields = 0;
+        for (int i = 0; i < RS2_FRAME_METADATA_COUNT; ++i)
+        {
+            const auto field = (rs2_frame_metadata_value)i;
+            if (frame.supports_frame_metadata(field))
+            {
+                this->values[i] = frame.get_frame_metadata(field);
+                this->supportedFields |= uint64_t(1) << i;
+            }
+            else
+            {
+                this->values[i] = 0;
+            }
+        }
+    }
+
+    void FrameMetadata::clear()
+    {
+        this->valid = false;
+        this->frameNumber = 0;
+        this->timestamp = 0.0;
+        this->timestampDomain = RS2_TIMESTAMP_DOMAIN_HARDWARE_CLOCK;
+        this->supportedFields = 0;
+        this->values.fill(0);
+    }
+
+    bool FrameMetadata::supports(rs2_frame_metadata_value field) const
+    {
+        return field >= 0 && field < RS2_FRAME_METADATA_COUNT && (this->supportedFields & (uint64_t(1) << field));
+    }
+
+    int64_t FrameMetadata::get(rs2_frame_metadata_value field, int64_t defaultValue) const
+    {
+        return this->supports(field) ? this->values[field] : defaultValue;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "librealsense2/rs.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace ofxRealSense2
+{
+    // Plain copy of a frame's metadata, captured on the worker thread so it can
+    // be read later without holding on to the frame or calling into librealsense.
+    struct FrameMetadata
+    {
+        FrameMetadata();
+
+        // Reads every supported field from the frame, doesn't allocate.
+        void capture(const rs2::frame & frame);
+        void clear();
+
+        bool supports(rs2_frame_metadata_value field) const;
+        // Returns the default value for unsupported fields.
+        int64_t get(rs2_frame_metadata_value field, int64_t defaultValue = 0) const;
+
+        bool valid;
+        unsigned long long frameNumber;
+        // Milliseconds, in the timestamp domain.
+        double timestamp;
+        rs2_timestamp_domain timestampDomain;
+        // One bit per rs2_frame_metadata_value.
+        uint64_t supportedFields;
+        std::array<int64_t, RS2_FRAME_METADATA_COUNT> values;
+    };
+}
\ No newline at end of file
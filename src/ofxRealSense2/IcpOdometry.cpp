@@ -0,0 +1,426 @@
+#include "IcpOdometry.h"
+
+#include "DepthPyramid.h"
+#include "NormalEstimator.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace ofxRealSense2
+{
+    namespace
+    {
+        // Row buffer layout, one array per Jacobian entry plus the residual.
+        const int NumTerms = 7;
+
+        glm::mat3 rotationFromVector(const glm::vec3 & omega)
+        {
+            const float angle = glm::length(omega);
+            glm::mat3 rotation;
+            if (angle < 1e-9f) return rotation;
+
+            // Rodrigues, columns of cos * I + sin * [k]x + (1 - cos) * k * k^T.
+            const glm::vec3 k = omega / angle;
+            const float c = std::cos(angle);
+            const float s = std::sin(angle);
+            const float t = 1.0f - c;
+            rotation[0] = glm::vec3(c + t * k.x * k.x, t * k.x * k.y + s * k.z, t * k.x * k.z - s * k.y);
+            rotation[1] = glm::vec3(t * k.x * k.y - s * k.z, c + t * k.y * k.y, t * k.y * k.z + s * k.x);
+            rotation[2] = glm::vec3(t * k.x * k.z + s * k.y, t * k.y * k.z - s * k.x, c + t * k.z * k.z);
+            return rotation;
+        }
+
+        glm::mat4 toMatrix(const glm::mat3 & rotation, const glm::vec3 & translation)
+        {
+            glm::mat4 matrix;
+            matrix[0] = glm::vec4(rotation[0], 0.0f);
+            matrix[1] = glm::vec4(rotation[1], 0.0f);
+            matrix[2] = glm::vec4(rotation[2], 0.0f);
+            matrix[3] = glm::vec4(translation, 1.0f);
+            return matrix;
+        }
+    }
+
+    IcpOdometry::IcpOdometry()
+        : iterations({ 10, 5, 4 })
+        , maxDistance(0.1f)
+        , maxAngle(30.0f)
+        , hasPrevious(false)
+    {
+
+    }
+
+    void IcpOdometry::setIterations(const std::vector<int> & iterations)
+    {
+        if (iterations.empty()) return;
+
+        this->iterations = iterations;
+        this->reset();
+    }
+
+    void IcpOdometry::setMaxDistance(float maxDistance)
+    {
+        this->maxDistance = maxDistance;
+    }
+
+    void IcpOdometry::setMaxAngle(float maxAngle)
+    {
+        this->maxAngle = maxAngle;
+    }
+
+    void IcpOdometry::reset()
+    {
+        this->hasPrevious = false;
+        this->relativePose = glm::mat4();
+        this->pose = glm::mat4();
+        this->iterationStats.clear();
+    }
+
+    bool IcpOdometry::update(const uint16_t * depthData, const Intrinsics & intrinsics, float depthScale)
+    {
+        this->iterationStats.clear();
+        this->relativePose = glm::mat4();
+        if (!intrinsics.isValid()) return false;
+
+        this->buildLevels(depthData, intrinsics, depthScale);
+
+        const bool comparable = this->hasPrevious && this->previousLevels[0].width == this->levels[0].width && this->previousLevels[0].height == this->levels[0].height;
+        bool tracked = comparable;
+        if (comparable)
+        {
+            // Start from no motion, the previous motion is a poor guess for handheld cameras.
+            glm::mat3 rotation;
+            glm::vec3 translation(0.0f);
+            for (int level = (int)this->levels.size() - 1; level >= 0 && tracked; --level)
+            {
+                for (int i = 0; i < this->iterations[level]; ++i)
+                {
+                    const auto startTime = std::chrono::steady_clock::now();
+
+                    Accumulator sum;
+                    this->accumulate(level, rotation, translation, sum);
+
+                    double x[6];
+                    const bool solved = sum.count >= 6 && solve(sum, x);
+
+                    Iteration stats;
+                    stats.level = level;
+                    stats.numCorrespondences = sum.count;
+                    stats.error = sum.count ? (float)std::sqrt(sum.error / sum.count) : 0.0f;
+
+                    if (solved)
+                    {
+                        // Apply the increment on the left, it was linearized around the current estimate.
+                        const glm::mat3 step = rotationFromVector(glm::vec3((float)x[0], (float)x[1], (float)x[2]));
+                        rotation = step * rotation;
+                        translation = step * translation + glm::vec3((float)x[3], (float)x[4], (float)x[5]);
+                    }
+
+                    stats.duration = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+                    this->iterationStats.push_back(stats);
+
+                    if (!solved)
+                    {
+                        tracked = (level > 0);
+                        break;
+                    }
+
+                    // Converged, move on to the next level.
+                    if (std::max({ std::fabs(x[0]), std::fabs(x[1]), std::fabs(x[2]), std::fabs(x[3]), std::fabs(x[4]), std::fabs(x[5]) }) < 1e-5) break;
+                }
+            }
+
+            if (tracked)
+            {
+                this->relativePose = toMatrix(rotation, translation);
+                this->pose = this->pose * this->relativePose;
+            }
+        }
+
+        std::swap(this->levels, this->previousLevels);
+        this->hasPrevious = true;
+        return tracked;
+    }
+
+    const glm::mat4 & IcpOdometry::getRelativePose() const
+    {
+        return this->relativePose;
+    }
+
+    const glm::mat4 & IcpOdometry::getPose() const
+    {
+        return this->pose;
+    }
+
+    const std::vector<IcpOdometry::Iteration> & IcpOdometry::getIterations() const
+    {
+        return this->iterationStats;
+    }
+
+    void IcpOdometry::buildLevels(const uint16_t * depthData, const Intrinsics & intrinsics, float depthScale)
+    {
+        const auto & native = intrinsics.getNative();
+        this->levels.resize(this->iterations.size());
+        for (size_t i = 0; i < this->levels.size(); ++i)
+        {
+            auto & level = this->levels[i];
+            if (i == 0)
+            {
+                level.width = native.width;
+                level.height = native.height;
+                level.fx = native.fx;
+                level.fy = native.fy;
+                level.ppx = native.ppx;
+                level.ppy = native.ppy;
+            }
+            else
+            {
+                // Median of 2x2 blocks, the block center is half a source pixel in.
+                const auto & source = this->levels[i - 1];
+                level.width = source.width / 2;
+                level.height = source.height / 2;
+                level.fx = source.fx * 0.5f;
+                level.fy = source.fy * 0.5f;
+                level.ppx = (source.ppx - 0.5f) * 0.5f;
+                level.ppy = (source.ppy - 0.5f) * 0.5f;
+                level.depth.resize(size_t(level.width) * level.height);
+                DepthPyramid::reduce(i == 1 ? depthData : source.depth.data(), source.width, source.height, DepthPyramid::Median, level.depth.data());
+            }
+
+            const uint16_t * levelDepth = (i == 0) ? depthData : level.depth.data();
+            const size_t numPixels = size_t(level.width) * level.height;
+            level.vertices.resize(numPixels);
+            level.normals.resize(numPixels);
+
+            const float invFx = 1.0f / level.fx;
+            const float invFy = 1.0f / level.fy;
+            for (int y = 0; y < level.height; ++y)
+            {
+                const float rayY = (y - level.ppy) * invFy;
+                for (int x = 0; x < level.width; ++x)
+                {
+                    const size_t idx = size_t(y) * level.width + x;
+                    const float depth = levelDepth[idx] * depthScale;
+                    level.vertices[idx] = glm::vec3((x - level.ppx) * invFx * depth, rayY * depth, depth);
+                }
+            }
+
+            NormalEstimator::estimate(level.vertices.data(), level.width, level.height, 1, level.normals.data());
+        }
+    }
+
+    void IcpOdometry::accumulate(int level, const glm::mat3 & rotation, const glm::vec3 & translation, Accumulator & total)
+    {
+        const int height = this->levels[level].height;
+        auto & pool = ThreadPool::getShared();
+        const int numStrips = std::max(1, std::min(pool.getConcurrency(), height / 8));
+        this->stripSums.resize(numStrips);
+        this->stripBuffers.resize(numStrips);
+        pool.parallelFor(numStrips, [&](int s)
+        {
+            this->accumulateRows(level, rotation, translation, height * s / numStrips, height * (s + 1) / numStrips, this->stripBuffers[s], this->stripSums[s]);
+        });
+
+        total = Accumulator();
+        for (const auto & sum : this->stripSums)
+        {
+            for (int i = 0; i < 21; ++i) total.a[i] += sum.a[i];
+            for (int i = 0; i < 6; ++i) total.b[i] += sum.b[i];
+            total.error += sum.error;
+            total.count += sum.count;
+        }
+    }
+
+    void IcpOdometry::accumulateRows(int level, const glm::mat3 & rotation, const glm::vec3 & translation, int y0, int y1, std::vector<float> & buffer, Accumulator & sum) const
+    {
+        const auto & current = this->levels[level];
+        const auto & previous = this->previousLevels[level];
+        const int width = current.width;
+        const float maxDistanceSq = this->maxDistance * this->maxDistance;
+        const float minCosine = std::cos(glm::radians(this->maxAngle));
+
+        sum = Accumulator();
+        buffer.resize(size_t(width) * NumTerms);
+        float * terms[NumTerms];
+        for (int k = 0; k < NumTerms; ++k)
+        {
+            terms[k] = buffer.data() + size_t(k) * width;
+        }
+
+        for (int y = y0; y < y1; ++y)
+        {
+            // Find the row's matches first, then reduce them together.
+            int count = 0;
+            for (int x = 0; x < width; ++x)
+            {
+                const size_t idx = size_t(y) * width + x;
+                const auto & vertex = current.vertices[idx];
+                const auto & normal = current.normals[idx];
+                if (vertex.z <= 0.0f || normal.z == 0.0f) continue;
+
+                const glm::vec3 point = rotation * vertex + translation;
+                if (point.z <= 0.0f) continue;
+
+                const int u = (int)std::floor(point.x / point.z * previous.fx + previous.ppx + 0.5f);
+                const int v = (int)std::floor(point.y / point.z * previous.fy + previous.ppy + 0.5f);
+                if (u < 0 || v < 0 || u >= previous.width || v >= previous.height) continue;
+
+                const size_t match = size_t(v) * previous.width + u;
+                const auto & target = previous.vertices[match];
+                const auto & targetNormal = previous.normals[match];
+                if (target.z <= 0.0f || targetNormal.z == 0.0f) continue;
+
+                const glm::vec3 delta = point - target;
+                if (glm::dot(delta, delta) > maxDistanceSq) continue;
+                if (glm::dot(rotation * normal, targetNormal) < minCosine) continue;
+
+                const glm::vec3 cross = glm::cross(point, targetNormal);
+                terms[0][count] = cross.x;
+                terms[1][count] = cross.y;
+                terms[2][count] = cross.z;
+                terms[3][count] = targetNormal.x;
+                terms[4][count] = targetNormal.y;
+                terms[5][count] = targetNormal.z;
+                terms[6][count] = glm::dot(targetNormal, delta);
+                ++count;
+            }
+
+            // Upper triangle of J^T J, J^T r and r^T r, in float per row and double across rows.
+            float rowSums[28] = {};
+            int i = 0;
+
+#ifdef OFX_REALSENSE2_SSE2
+            __m128 acc[28];
+            for (int k = 0; k < 28; ++k)
+            {
+                acc[k] = _mm_setzero_ps();
+            }
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128 j[NumTerms];
+                for (int k = 0; k < NumTerms; ++k)
+                {
+                    j[k] = _mm_loadu_ps(terms[k] + i);
+                }
+
+                int entry = 0;
+                for (int r = 0; r < NumTerms; ++r)
+                {
+                    for (int c = r; c < NumTerms; ++c)
+                    {
+                        acc[entry] = _mm_add_ps(acc[entry], _mm_mul_ps(j[r], j[c]));
+                        ++entry;
+                    }
+                }
+            }
+            for (int k = 0; k < 28; ++k)
+            {
+                alignas(16) float lanes[4];
+                _mm_store_ps(lanes, acc[k]);
+                rowSums[k] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+            }
+#endif
+
+            for (; i < count; ++i)
+            {
+                int entry = 0;
+                for (int r = 0; r < NumTerms; ++r)
+                {
+                    for (int c = r; c < NumTerms; ++c)
+                    {
+                        rowSums[entry++] += terms[r][i] * terms[c][i];
+                    }
+                }
+            }
+
+            // Entries come out row by row of the 7x7 upper triangle, the last column
+            // of each row is the residual term and the final entry is r^2.
+            int entry = 0;
+            int aEntry = 0;
+            for (int r = 0; r < NumTerms; ++r)
+            {
+                for (int c = r; c < NumTerms; ++c)
+                {
+                    if (r == NumTerms - 1)
+                    {
+                        sum.error += rowSums[entry];
+                    }
+                    else if (c == NumTerms - 1)
+                    {
+                        sum.b[r] += rowSums[entry];
+                    }
+                    else
+                    {
+                        sum.a[aEntry++] += rowSums[entry];
+                    }
+                    ++entry;
+                }
+            }
+            sum.count += count;
+        }
+    }
+
+    bool IcpOdometry::solve(const Accumulator & sum, double x[6])
+    {
+        // Cholesky of the symmetric system A x = -b.
+        double a[6][6];
+        int entry = 0;
+        for (int r = 0; r < 6; ++r)
+        {
+            for (int c = r; c < 6; ++c)
+            {
+                a[r][c] = sum.a[entry];
+                a[c][r] = sum.a[entry];
+                ++entry;
+            }
+        }
+
+        double l[6][6] = {};
+        for (int r = 0; r < 6; ++r)
+        {
+            for (int c = 0; c <= r; ++c)
+            {
+                double value = a[r][c];
+                for (int k = 0; k < c; ++k)
+                {
+                    value -= l[r][k] * l[c][k];
+                }
+
+                if (r == c)
+                {
+                    // Degenerate geometry, like a single plane, leaves the system singular.
+                    if (value <= 1e-12 * std::max(a[r][r], 1.0)) return false;
+                    l[r][r] = std::sqrt(value);
+                }
+                else
+                {
+                    l[r][c] = value / l[c][c];
+                }
+            }
+        }
+
+        double y[6];
+        for (int r = 0; r < 6; ++r)
+        {
+            double value = -sum.b[r];
+            for (int k = 0; k < r; ++k)
+            {
+                value -= l[r][k] * y[k];
+            }
+            y[r] = value / l[r][r];
+        }
+        for (int r = 5; r >= 0; --r)
+        {
+            double value = y[r];
+            for (int k = r + 1; k < 6; ++k)
+            {
+                value -= l[k][r] * x[k];
+            }
+            x[r] = value / l[r][r];
+        }
+        return true;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "ofVectorMath.h"
+
+#include "Intrinsics.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace ofxRealSense2
+{
+    // Frame to frame camera tracking with point-to-plane ICP. Each depth frame
+    // is aligned to the previous one coarse to fine over a depth pyramid,
+    // matching points by projecting them into the previous frame. Depth is
+    // treated as undistorted, like the 400-series depth stream.
+    class IcpOdometry
+    {
+    public:
+        struct Iteration
+        {
+            int level;
+            int numCorrespondences;
+            // RMS point-to-plane distance in meters, before the step.
+            float error;
+            // Milliseconds spent on the iteration.
+            float duration;
+        };
+
+        IcpOdometry();
+
+        // Iterations per level, finest level first, the number of entries sets the number of levels.
+        void setIterations(const std::vector<int> & iterations);
+        // Matches further apart than this distance (meters) or angle (degrees) are rejected.
+        void setMaxDistance(float maxDistance);
+        void setMaxAngle(float maxAngle);
+
+        // Forgets the previous frame and resets the pose.
+        void reset();
+
+        // Aligns the frame to the previous one, returns false if there was no
+        // previous frame or tracking failed, in which case the pose is kept.
+        bool update(const uint16_t * depthData, const Intrinsics & intrinsics, float depthScale);
+
+        // Maps the current depth camera space to the previous one.
+        const glm::mat4 & getRelativePose() const;
+        // Maps the current depth camera space to the first frame's.
+        const glm::mat4 & getPose() const;
+
+        // Iterations of the last update, coarsest first.
+        const std::vector<Iteration> & getIterations() const;
+
+    private:
+        struct Level
+        {
+            int width;
+            int height;
+            float fx;
+            float fy;
+            float ppx;
+            float ppy;
+            std::vector<uint16_t> depth;
+            std::vector<glm::vec3> vertices;
+            std::vector<glm::vec3> normals;
+        };
+
+        // Sums of the 6x6 normal equations, upper triangle only.
+        struct Accumulator
+        {
+            double a[21];
+            double b[6];
+            double error;
+            int count;
+        };
+
+        void buildLevels(const uint16_t * depthData, const Intrinsics & intrinsics, float depthScale);
+        void accumulate(int level, const glm::mat3 & rotation, const glm::vec3 & translation, Accumulator & total);
+        void accumulateRows(int level, const glm::mat3 & rotation, const glm::vec3 & translation, int y0, int y1, std::vector<float> & buffer, Accumulator & sum) const;
+
+        static bool solve(const Accumulator & sum, double x[6]);
+
+    private:
+        std::vector<int> iterations;
+        float maxDistance;
+        float maxAngle;
+
+        std::vector<Level> levels;
+        std::vector<Level> previousLevels;
+        bool hasPrevious;
+
+        std::vector<Accumulator> stripSums;
+        std::vector<std::vector<float>> stripBuffers;
+
+        glm::mat4 relativePose;
+        glm::mat4 pose;
+        std::vector<Iteration> iterationStats;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include "Imu.h"
+
+#include <algorithm>
+
+namespace ofxRealSense2
+{
+    bool ImuSample::fromFrame(const rs2::frame & frame, ImuSample & sample)
+    {
+        auto motionFrame = frame.as<rs2::motion_frame>();
+        if (!motionFrame) return false;
+
+        const auto streamType = motionFrame.get_profile().stream_type();
+        if (streamType != RS2_STREAM_GYRO && streamType != RS2_STREAM_ACCEL) return false;
+
+        const auto data = motionFrame.get_motion_data();
+        sample.timestamp = motionFrame.get_timestamp();
+        sample.value = glm::vec3(data.x, data.y, data.z);
+        sample.type = (streamType == RS2_STREAM_GYRO) ? ImuSample::Gyro : ImuSample::Accel;
+        return true;
+    }
+
+    ImuHistory::ImuHistory(size_t capacity)
+        : samples(std::max<size_t>(capacity, 1))
+        , start(0)
+        , count(0)
+    {
+
+    }
+
+    void ImuHistory::add(const ImuSample * samples, size_t count)
+    {
+        const size_t capacity = this->samples.size();
+        for (size_t i = 0; i < count; ++i)
+        {
+            // Overwrite the oldest sample once full.
+            this->samples[(this->start + this->count) % capacity] = samples[i];
+            if (this->count < capacity)
+            {
+                ++this->count;
+            }
+            else
+            {
+                this->start = (this->start + 1) % capacity;
+            }
+        }
+    }
+
+    void ImuHistory::clear()
+    {
+        this->start = 0;
+        this->count = 0;
+    }
+
+    size_t ImuHistory::read(double since, std::vector<ImuSample> & samples) const
+    {
+        samples.clear();
+
+        // Gyro and accel samples are interleaved and not strictly ordered between
+        // each other, so walk back until both sensors are past the timestamp.
+        size_t first = this->count;
+        bool reached[2] = { false, false };
+        while (first > 0 && !(reached[ImuSample::Gyro] && reached[ImuSample::Accel]))
+        {
+            const auto & sample = this->at(first - 1);
+            if (sample.timestamp <= since)
+            {
+                reached[sample.type] = true;
+            }
+            --first;
+        }
+
+        for (size_t i = first; i < this->count; ++i)
+        {
+            const auto & sample = this->at(i);
+            if (sample.timestamp > since)
+            {
+                samples.push_back(sample);
+            }
+        }
+        return samples.size();
+    }
+
+    bool ImuHistory::interpolate(double timestamp, ImuFrame & frame) const
+    {
+        frame.timestamp = timestamp;
+        frame.valid = this->interpolate(ImuSample::Gyro, timestamp, frame.gyro) &&
+            this->interpolate(ImuSample::Accel, timestamp, frame.accel);
+        return frame.valid;
+    }
+
+    size_t ImuHistory::size() const
+    {
+        return this->count;
+    }
+
+    const ImuSample & ImuHistory::at(size_t idx) const
+    {
+        return this->samples[(this->start + idx) % this->samples.size()];
+    }
+
+    bool ImuHistory::interpolate(ImuSample::Type type, double timestamp, glm::vec3 & value) const
+    {
+        // Find the last sample at or before the timestamp, and the one after it.
+        const ImuSample * after = nullptr;
+        for (size_t i = this->count; i > 0; --i)
+        {
+            const auto & sample = this->at(i - 1);
+            if (sample.type != type) continue;
+
+            if (sample.timestamp <= timestamp)
+            {
+                if (after && after->timestamp > sample.timestamp)
+                {
+                    const float t = (float)((timestamp - sample.timestamp) / (after->timestamp - sample.timestamp));
+                    value = glm::mix(sample.value, after->value, t);
+                }
+                else
+                {
+                    value = sample.value;
+                }
+                return true;
+            }
+            after = &sample;
+        }
+
+        if (after)
+        {
+            // All samples are newer, use the oldest one.
+            value = after->value;
+            return true;
+        }
+        return false;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ofVectorMath.h"
+#include "librealsense2/rs.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace ofxRealSense2
+{
+    struct ImuSample
+    {
+        enum Type : uint8_t
+        {
+            Gyro,
+            Accel
+        };
+
+        // Milliseconds, in the same clock domain as the video frames.
+        double timestamp;
+        // Radians per second for the gyro, meters per second squared for the accelerometer.
+        glm::vec3 value;
+        Type type;
+
+        // Reads a gyro or accelerometer frame, returns false for any other frame.
+        static bool fromFrame(const rs2::frame & frame, ImuSample & sample);
+    };
+
+    // Motion at a point in time, interpolated between the surrounding samples.
+    struct ImuFrame
+    {
+        double timestamp;
+        glm::vec3 gyro;
+        glm::vec3 accel;
+        bool valid;
+    };
+
+    // Recent IMU samples in arrival order, in a fixed-size circular history.
+    class ImuHistory
+    {
+    public:
+        ImuHistory(size_t capacity = 4096);
+
+        void add(const ImuSample * samples, size_t count);
+        void clear();
+
+        // Replaces the output with the samples newer than the timestamp, oldest first.
+        size_t read(double since, std::vector<ImuSample> & samples) const;
+
+        // Interpolates both sensors at the timestamp. The frame is only valid
+        // if both sensors have samples, the nearest sample is used past either end.
+        bool interpolate(double timestamp, ImuFrame & frame) const;
+
+        size_t size() const;
+
+    private:
+        const ImuSample & at(size_t idx) const;
+        bool interpolate(ImuSample::Type type, double timestamp, glm::vec3 & value) const;
+
+    private:
+        std::vector<ImuSample> samples;
+        size_t start;
+        size_t count;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include "Intrinsics.h"
+
+// rsutil.h defines its helpers as static functions, most of them are unused here.
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#elif defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4505)
+#endif
+#include "librealsense2/rsutil.h"
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#elif defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#include "Simd.h"
+
+namespace ofxRealSense2
+{
+    Intrinsics::Intrinsics()
+        : intrinsics()
+        , valid(false)
+        , pinhole(true)
+    {
+
+    }
+
+    Intrinsics::Intrinsics(const rs2_intrinsics & intrinsics)
+        : intrinsics(intrinsics)
+        , valid(intrinsics.width > 0 && intrinsics.height > 0 && intrinsics.fx != 0.0f && intrinsics.fy != 0.0f)
+        , pinhole(true)
+    {
+        for (int i = 0; i < 5; ++i)
+        {
+            if (intrinsics.coeffs[i] != 0.0f)
+            {
+                this->pinhole = false;
+            }
+        }
+        if (intrinsics.model == RS2_DISTORTION_FTHETA)
+        {
+            this->pinhole = false;
+        }
+    }
+
+    bool Intrinsics::isValid() const
+    {
+        return this->valid;
+    }
+
+    bool Intrinsics::isPinhole() const
+    {
+        return this->pinhole;
+    }
+
+    int Intrinsics::getWidth() const
+    {
+        return this->intrinsics.width;
+    }
+
+    int Intrinsics::getHeight() const
+    {
+        return this->intrinsics.height;
+    }
+
+    const rs2_intrinsics & Intrinsics::getNative() const
+    {
+        return this->intrinsics;
+    }
+
+    glm::vec3 Intrinsics::deproject(const glm::vec2 & pixel, float depth) const
+    {
+        if (!this->valid) return glm::vec3(0.0f);
+
+        if (this->pinhole)
+        {
+            return glm::vec3((pixel.x - this->intrinsics.ppx) / this->intrinsics.fx * depth,
+                             (pixel.y - this->intrinsics.ppy) / this->intrinsics.fy * depth,
+                             depth);
+        }
+
+        const float coords[2] = { pixel.x, pixel.y };
+        float point[3];
+        rs2_deproject_pixel_to_point(point, &this->intrinsics, coords, depth);
+        return glm::vec3(point[0], point[1], point[2]);
+    }
+
+    glm::vec2 Intrinsics::project(const glm::vec3 & point) const
+    {
+        if (!this->valid || point.z <= 0.0f) return glm::vec2(0.0f);
+
+        if (this->pinhole)
+        {
+            return glm::vec2(point.x / point.z * this->intrinsics.fx + this->intrinsics.ppx,
+                             point.y / point.z * this->intrinsics.fy + this->intrinsics.ppy);
+        }
+
+        const float coords[3] = { point.x, point.y, point.z };
+        float pixel[2];
+        rs2_project_point_to_pixel(pixel, &this->intrinsics, coords);
+        return glm::vec2(pixel[0], pixel[1]);
+    }
+
+    void Intrinsics::deproject(const glm::vec2 * pixels, size_t count, const uint16_t * depthData, float depthScale, glm::vec3 * points, float * distances) const
+    {
+        const int width = this->intrinsics.width;
+        const int height = this->intrinsics.height;
+
+        // Depth lookup, with zero for anything off the image.
+        auto sample = [&](const glm::vec2 & pixel)
+        {
+            const int x = (int)pixel.x;
+            const int y = (int)pixel.y;
+            if (!this->valid || !depthData || pixel.x < 0.0f || pixel.y < 0.0f || x >= width || y >= height) return 0.0f;
+            return depthData[y * width + x] * depthScale;
+        };
+
+        size_t i = 0;
+
+#ifdef OFX_REALSENSE2_SSE2
+        if (this->pinhole && this->valid)
+        {
+            const __m128 ppx4 = _mm_set1_ps(this->intrinsics.ppx);
+            const __m128 ppy4 = _mm_set1_ps(this->intrinsics.ppy);
+            const __m128 invFx4 = _mm_set1_ps(1.0f / this->intrinsics.fx);
+            const __m128 invFy4 = _mm_set1_ps(1.0f / this->intrinsics.fy);
+            alignas(16) float results[3][4];
+
+            for (; i + 4 <= count; i += 4)
+            {
+                const __m128 z = _mm_setr_ps(sample(pixels[i]), sample(pixels[i + 1]), sample(pixels[i + 2]), sample(pixels[i + 3]));
+                if (distances)
+                {
+                    _mm_storeu_ps(distances + i, z);
+                }
+                if (!points) continue;
+
+                // Deinterleave the xy pairs.
+                const __m128 pixelsA = _mm_loadu_ps(&pixels[i].x);
+                const __m128 pixelsB = _mm_loadu_ps(&pixels[i + 2].x);
+                const __m128 px = _mm_shuffle_ps(pixelsA, pixelsB, _MM_SHUFFLE(2, 0, 2, 0));
+                const __m128 py = _mm_shuffle_ps(pixelsA, pixelsB, _MM_SHUFFLE(3, 1, 3, 1));
+
+                _mm_store_ps(results[0], _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(px, ppx4), invFx4), z));
+                _mm_store_ps(results[1], _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(py, ppy4), invFy4), z));
+                _mm_store_ps(results[2], z);
+                for (int j = 0; j < 4; ++j)
+                {
+                    points[i + j] = glm::vec3(results[0][j], results[1][j], results[2][j]);
+                }
+            }
+        }
+#endif
+
+        for (; i < count; ++i)
+        {
+            const float depth = sample(pixels[i]);
+            if (distances)
+            {
+                distances[i] = depth;
+            }
+            if (points)
+            {
+                points[i] = depth > 0.0f ? this->deproject(pixels[i], depth) : glm::vec3(0.0f);
+            }
+        }
+    }
+}
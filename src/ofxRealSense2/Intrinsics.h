@@ -0,0 +1,40 @@
+#pragma once
+
+#include "librealsense2/rs.hpp"
+
+#include "ofVectorMath.h"
+
+#include <cstdint>
+
+namespace ofxRealSense2
+{
+    // Cached copy of a stream's intrinsics, for projecting without going through
+    // librealsense frames. Streams without distortion coefficients (like the
+    // 400-series depth stream) use a SIMD pinhole path.
+    class Intrinsics
+    {
+    public:
+        Intrinsics();
+        Intrinsics(const rs2_intrinsics & intrinsics);
+
+        bool isValid() const;
+        bool isPinhole() const;
+
+        int getWidth() const;
+        int getHeight() const;
+        const rs2_intrinsics & getNative() const;
+
+        glm::vec3 deproject(const glm::vec2 & pixel, float depth) const;
+        glm::vec2 project(const glm::vec3 & point) const;
+
+        // Looks up the raw depth under each pixel and deprojects it, in meters.
+        // Pixels outside the image or without depth give a zero distance and position.
+        // Either output can be null.
+        void deproject(const glm::vec2 * pixels, size_t count, const uint16_t * depthData, float depthScale, glm::vec3 * points, float * distances) const;
+
+    private:
+        rs2_intrinsics intrinsics;
+        bool valid;
+        bool pinhole;
+    };
+}
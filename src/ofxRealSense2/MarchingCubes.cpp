@@ -0,0 +1,189 @@
+#include "MarchingCubes.h"
+
+#include "ofVectorMath.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace ofxRealSense2
+{
+    namespace
+    {
+        // Up to 10 triangles per case, plus the terminator.
+        const int MaxEntries = 32;
+
+        struct CaseTable
+        {
+            int edgeCorners[12][2];
+            int8_t triangles[256][MaxEntries];
+
+            CaseTable()
+            {
+                int cornerEdges[8][8];
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    int k = 0;
+                    for (int corner = 0; corner < 8; ++corner)
+                    {
+                        if (corner & (1 << axis)) continue;
+
+                        const int edge = axis * 4 + k++;
+                        this->edgeCorners[edge][0] = corner;
+                        this->edgeCorners[edge][1] = corner | (1 << axis);
+                        cornerEdges[corner][corner | (1 << axis)] = edge;
+                        cornerEdges[corner | (1 << axis)][corner] = edge;
+                    }
+                }
+
+                for (int cubeIndex = 0; cubeIndex < 256; ++cubeIndex)
+                {
+                    this->buildCase(cubeIndex, cornerEdges);
+                }
+            }
+
+            static glm::vec3 getCorner(int corner)
+            {
+                return glm::vec3(float(corner & 1), float((corner >> 1) & 1), float((corner >> 2) & 1));
+            }
+
+            void buildCase(int cubeIndex, const int cornerEdges[8][8])
+            {
+                auto isInside = [cubeIndex](int corner)
+                {
+                    return (cubeIndex & (1 << corner)) != 0;
+                };
+
+                // Contour segments per face, linking each edge where the boundary walk
+                // leaves the inside to the edge where it last entered. Every crossing
+                // then has exactly one segment out, and the segments close into loops.
+                int next[12];
+                std::fill(next, next + 12, -1);
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    const int u = 1 << ((axis + 1) % 3);
+                    const int v = 1 << ((axis + 2) % 3);
+                    for (int side = 0; side < 2; ++side)
+                    {
+                        // Counter-clockwise seen from outside the cell.
+                        const int base = side ? (1 << axis) : 0;
+                        int corners[4] = { base, base | u, base | u | v, base | v };
+                        if (!side)
+                        {
+                            std::swap(corners[1], corners[3]);
+                        }
+
+                        for (int k = 0; k < 4; ++k)
+                        {
+                            const int from = corners[k];
+                            const int to = corners[(k + 1) % 4];
+                            if (!isInside(from) || isInside(to)) continue;
+
+                            for (int j = 1; j < 4; ++j)
+                            {
+                                const int prevFrom = corners[(k + 4 - j) % 4];
+                                const int prevTo = corners[(k + 5 - j) % 4];
+                                if (!isInside(prevFrom) && isInside(prevTo))
+                                {
+                                    next[cornerEdges[from][to]] = cornerEdges[prevFrom][prevTo];
+                                    break;
+                                }
+                            }
+                        }
+                    }
+                }
+
+                int8_t * out = this->triangles[cubeIndex];
+                bool visited[12] = {};
+                for (int start = 0; start < 12; ++start)
+                {
+                    if (next[start] < 0 || visited[start]) continue;
+
+                    std::vector<int> loop;
+                    for (int edge = start; !visited[edge]; edge = next[edge])
+                    {
+                        visited[edge] = true;
+                        loop.push_back(edge);
+                    }
+
+                    // Wind the loop so its normal points from the inside corners to the outside ones.
+                    glm::vec3 normal(0.0f);
+                    glm::vec3 outward(0.0f);
+                    for (size_t i = 0; i < loop.size(); ++i)
+                    {
+                        const glm::vec3 a = this->getMidpoint(loop[i]);
+                        const glm::vec3 b = this->getMidpoint(loop[(i + 1) % loop.size()]);
+                        normal += glm::cross(a, b);
+
+                        const int c0 = this->edgeCorners[loop[i]][0];
+                        const int c1 = this->edgeCorners[loop[i]][1];
+                        outward += isInside(c0) ? getCorner(c1) - getCorner(c0) : getCorner(c0) - getCorner(c1);
+                    }
+                    if (glm::dot(normal, outward) < 0.0f)
+                    {
+                        std::reverse(loop.begin(), loop.end());
+                    }
+
+                    // Fan from a crossing whose chords all cut through the cell. A chord between
+                    // two crossings on the same face would lie in that face, where the neighbouring
+                    // cell has no matching edge.
+                    const size_t count = loop.size();
+                    size_t first = 0;
+                    for (; first < count; ++first)
+                    {
+                        size_t i = 2;
+                        while (i + 1 < count && !(this->getFaces(loop[first]) & this->getFaces(loop[(first + i) % count])))
+                        {
+                            ++i;
+                        }
+                        if (i + 1 >= count) break;
+                    }
+                    first %= count;
+
+                    for (size_t i = 1; i + 1 < count; ++i)
+                    {
+                        *out++ = loop[first];
+                        *out++ = loop[(first + i) % count];
+                        *out++ = loop[(first + i + 1) % count];
+                    }
+                }
+                *out = -1;
+            }
+
+            // One bit per cell face, two per axis for the low and high side.
+            int getFaces(int edge) const
+            {
+                const int c0 = this->edgeCorners[edge][0];
+                const int c1 = this->edgeCorners[edge][1];
+                int faces = 0;
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    if (((c0 ^ c1) >> axis) & 1) continue;
+
+                    faces |= 1 << (axis * 2 + ((c0 >> axis) & 1));
+                }
+                return faces;
+            }
+
+            glm::vec3 getMidpoint(int edge) const
+            {
+                return (getCorner(this->edgeCorners[edge][0]) + getCorner(this->edgeCorners[edge][1])) * 0.5f;
+            }
+        };
+
+        const CaseTable & getCaseTable()
+        {
+            static const CaseTable table;
+            return table;
+        }
+    }
+
+    int MarchingCubes::getEdgeCorner(int edge, int end)
+    {
+        return getCaseTable().edgeCorners[edge][end];
+    }
+
+    const int8_t * MarchingCubes::getTriangles(int cubeIndex)
+    {
+        return getCaseTable().triangles[cubeIndex & 0xFF];
+    }
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ofxRealSense2
+{
+    // Case table for marching cubes. Corner i of a cell is at offset
+    // (i & 1, (i >> 1) & 1, (i >> 2) & 1), and a case sets bit i when corner i
+    // is inside (below the iso value). Ambiguous faces always separate the
+    // inside corners, so neighbouring cells agree and surfaces are watertight.
+    // Triangles wind counter-clockwise seen from outside.
+    class MarchingCubes
+    {
+    public:
+        // The two corners of an edge, edges 0-3 run along x, 4-7 along y, 8-11 along z.
+        static int getEdgeCorner(int edge, int end);
+
+        // Edges of the triangles for a case, three per triangle, ended by -1.
+        static const int8_t * getTriangles(int cubeIndex);
+    };
+}
\ No newline at end of file
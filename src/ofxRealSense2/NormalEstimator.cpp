@@ -0,0 +1,166 @@
+#include "NormalEstimator.h"
+
+#include "Simd.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ofxRealSense2
+{
+    namespace
+    {
+        // Difference across the center, or to the center when one side is missing.
+        inline bool difference(const glm::vec3 & prev, bool hasPrev, const glm::vec3 & center, const glm::vec3 & next, bool hasNext, glm::vec3 & delta)
+        {
+            hasPrev = hasPrev && prev.z > 0.0f;
+            hasNext = hasNext && next.z > 0.0f;
+            if (hasPrev && hasNext)
+            {
+                delta = next - prev;
+            }
+            else if (hasNext)
+            {
+                delta = next - center;
+            }
+            else if (hasPrev)
+            {
+                delta = center - prev;
+            }
+            else
+            {
+                return false;
+            }
+            return true;
+        }
+
+        inline glm::vec3 estimatePoint(const glm::vec3 * vertices, int width, int height, int radius, int x, int y)
+        {
+            const size_t idx = size_t(y) * width + x;
+            const auto & center = vertices[idx];
+            if (center.z <= 0.0f) return glm::vec3(0.0f);
+
+            const size_t rowOffset = size_t(radius) * width;
+            const bool hasLeft = x >= radius;
+            const bool hasRight = x + radius < width;
+            const bool hasUp = y >= radius;
+            const bool hasDown = y + radius < height;
+
+            glm::vec3 dx;
+            glm::vec3 dy;
+            if (!difference(hasLeft ? vertices[idx - radius] : center, hasLeft, center, hasRight ? vertices[idx + radius] : center, hasRight, dx) ||
+                !difference(hasUp ? vertices[idx - rowOffset] : center, hasUp, center, hasDown ? vertices[idx + rowOffset] : center, hasDown, dy))
+            {
+                return glm::vec3(0.0f);
+            }
+
+            // Image y points down, so this order faces the camera.
+            const glm::vec3 normal = glm::cross(dy, dx);
+            const float length = std::sqrt(glm::dot(normal, normal));
+            return (length > 0.0f) ? normal / length : glm::vec3(0.0f);
+        }
+
+#ifdef OFX_REALSENSE2_SSE2
+        // Splits 4 packed xyz vertices into one register per axis.
+        inline void load4(const glm::vec3 * vertices, __m128 & x, __m128 & y, __m128 & z)
+        {
+            const float * data = &vertices->x;
+            const __m128 a = _mm_loadu_ps(data);
+            const __m128 b = _mm_loadu_ps(data + 4);
+            const __m128 c = _mm_loadu_ps(data + 8);
+            x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+            y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+            z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+        }
+
+        inline void store4(glm::vec3 * vertices, __m128 x, __m128 y, __m128 z)
+        {
+            float * data = &vertices->x;
+            _mm_storeu_ps(data, _mm_shuffle_ps(_mm_unpacklo_ps(x, y), _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0)));
+            _mm_storeu_ps(data + 4, _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(data + 8, _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+        }
+#endif
+    }
+
+    void NormalEstimator::estimate(const glm::vec3 * vertices, int width, int height, int radius, glm::vec3 * normals)
+    {
+        radius = std::max(radius, 1);
+
+        // Rows only read their neighbours, so strips can run independently.
+        auto & pool = ThreadPool::getShared();
+        const int numStrips = std::max(1, std::min(pool.getConcurrency(), height / 16));
+        pool.parallelFor(numStrips, [&](int s)
+        {
+            estimateRows(vertices, width, height, radius, height * s / numStrips, height * (s + 1) / numStrips, normals);
+        });
+    }
+
+    void NormalEstimator::estimateRows(const glm::vec3 * vertices, int width, int height, int radius, int y0, int y1, glm::vec3 * normals)
+    {
+        const size_t rowOffset = size_t(radius) * width;
+        for (int y = y0; y < y1; ++y)
+        {
+            const size_t rowStart = size_t(y) * width;
+            int x = 0;
+
+#ifdef OFX_REALSENSE2_SSE2
+            if (y >= radius && y + radius < height)
+            {
+                // Border columns go through the scalar path.
+                for (; x < radius; ++x)
+                {
+                    normals[rowStart + x] = estimatePoint(vertices, width, height, radius, x, y);
+                }
+
+                const __m128 zero = _mm_setzero_ps();
+                const __m128 one = _mm_set1_ps(1.0f);
+                for (; x + 4 + radius <= width; x += 4)
+                {
+                    const size_t idx = rowStart + x;
+                    __m128 cx, cy, cz, lx, ly, lz, rx, ry, rz, ux, uy, uz, dx, dy, dz;
+                    load4(vertices + idx, cx, cy, cz);
+                    load4(vertices + idx - radius, lx, ly, lz);
+                    load4(vertices + idx + radius, rx, ry, rz);
+                    load4(vertices + idx - rowOffset, ux, uy, uz);
+                    load4(vertices + idx + rowOffset, dx, dy, dz);
+
+                    // Any missing neighbour needs the one-sided fallback.
+                    const __m128 valid = _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(cz, zero), _mm_cmpgt_ps(lz, zero)),
+                        _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(rz, zero), _mm_cmpgt_ps(uz, zero)), _mm_cmpgt_ps(dz, zero)));
+                    if (_mm_movemask_ps(valid) != 0xF)
+                    {
+                        for (int i = 0; i < 4; ++i)
+                        {
+                            normals[idx + i] = estimatePoint(vertices, width, height, radius, x + i, y);
+                        }
+                        continue;
+                    }
+
+                    const __m128 hx = _mm_sub_ps(rx, lx);
+                    const __m128 hy = _mm_sub_ps(ry, ly);
+                    const __m128 hz = _mm_sub_ps(rz, lz);
+                    const __m128 vx = _mm_sub_ps(dx, ux);
+                    const __m128 vy = _mm_sub_ps(dy, uy);
+                    const __m128 vz = _mm_sub_ps(dz, uz);
+
+                    // cross(v, h)
+                    const __m128 nx = _mm_sub_ps(_mm_mul_ps(vy, hz), _mm_mul_ps(vz, hy));
+                    const __m128 ny = _mm_sub_ps(_mm_mul_ps(vz, hx), _mm_mul_ps(vx, hz));
+                    const __m128 nz = _mm_sub_ps(_mm_mul_ps(vx, hy), _mm_mul_ps(vy, hx));
+
+                    // Degenerate neighbourhoods get a zero normal instead of NaN.
+                    const __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz));
+                    const __m128 scale = _mm_and_ps(_mm_div_ps(one, _mm_sqrt_ps(lengthSq)), _mm_cmpgt_ps(lengthSq, zero));
+                    store4(normals + idx, _mm_mul_ps(nx, scale), _mm_mul_ps(ny, scale), _mm_mul_ps(nz, scale));
+                }
+            }
+#endif
+
+            for (; x < width; ++x)
+            {
+                normals[rowStart + x] = estimatePoint(vertices, width, height, radius, x, y);
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "ofVectorMath.h"
+
+namespace ofxRealSense2
+{
+    // Per-point normals for organized point clouds, where the vertices are laid
+    // out in image rows. Each normal is the cross product of the horizontal and
+    // vertical differences between neighbours, falling back to one-sided
+    // differences next to missing points. Normals face the camera, points
+    // without depth get a zero normal.
+    class NormalEstimator
+    {
+    public:
+        // The radius is the distance to the neighbours used, larger radii smooth out noise.
+        static void estimate(const glm::vec3 * vertices, int width, int height, int radius, glm::vec3 * normals);
+
+    private:
+        static void estimateRows(const glm::vec3 * vertices, int width, int height, int radius, int y0, int y1, glm::vec3 * normals);
+    };
+}
\ No newline at end of file
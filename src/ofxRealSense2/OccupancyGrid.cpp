@@ -0,0 +1,442 @@
+#include "OccupancyGrid.h"
+
+#include "ofFileUtils.h"
+#include "ofLog.h"
+#include "ofMath.h"
+
+#include "Simd.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace ofxRealSense2
+{
+    namespace
+    {
+        const char FileMagic[4] = { 'O', 'C', 'C', '1' };
+
+        struct FileHeader
+        {
+            char magic[4];
+            int32_t width;
+            int32_t height;
+            float cellSize;
+            int32_t mode;
+            float decay;
+            uint64_t numFrames;
+        };
+
+        void appendVarint(std::vector<uint8_t> & data, uint32_t value)
+        {
+            while (value >= 0x80)
+            {
+                data.push_back(uint8_t(value | 0x80));
+                value >>= 7;
+            }
+            data.push_back(uint8_t(value));
+        }
+
+        bool readVarint(const uint8_t *& data, const uint8_t * end, uint32_t & value)
+        {
+            value = 0;
+            for (int shift = 0; data < end && shift < 35; shift += 7)
+            {
+                const uint8_t byte = *data++;
+                value |= uint32_t(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) return true;
+            }
+            return false;
+        }
+    }
+
+    OccupancyGrid::OccupancyGrid()
+        : width(0)
+        , height(0)
+        , cellSize(0.1f)
+        , groundPose(1.0f)
+        , minHeight(0.1f)
+        , maxHeight(2.0f)
+        , minPoints(4)
+        , mode(Cumulative)
+        , decay(0.999f)
+        , numFrames(0)
+        , rayIntrinsics()
+    {
+
+    }
+
+    void OccupancyGrid::setup(int width, int height, float cellSize)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->width = std::max(width, 0);
+        this->height = std::max(height, 0);
+        this->cellSize = std::max(cellSize, 0.001f);
+        this->counts.assign(size_t(this->width) * this->height, 0.0f);
+        this->numFrames = 0;
+    }
+
+    bool OccupancyGrid::isAllocated() const
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return !this->counts.empty();
+    }
+
+    void OccupancyGrid::setGroundPlane(const glm::vec4 & plane)
+    {
+        // Height along the normal, x along the camera's x projected on the plane,
+        // and the origin right under the camera.
+        const glm::vec3 up = glm::normalize(glm::vec3(plane));
+        glm::vec3 right = glm::vec3(1.0f, 0.0f, 0.0f) - up * up.x;
+        if (glm::length(right) < 1e-3f)
+        {
+            right = glm::vec3(0.0f, 0.0f, 1.0f) - up * up.z;
+        }
+        right = glm::normalize(right);
+        const glm::vec3 forward = glm::cross(up, right);
+        const float distance = plane.w / glm::length(glm::vec3(plane));
+
+        // Rows of the camera to ground rotation are the ground axes.
+        glm::mat4 pose;
+        pose[0] = glm::vec4(right.x, forward.x, up.x, 0.0f);
+        pose[1] = glm::vec4(right.y, forward.y, up.y, 0.0f);
+        pose[2] = glm::vec4(right.z, forward.z, up.z, 0.0f);
+        pose[3] = glm::vec4(0.0f, 0.0f, distance, 1.0f);
+        this->setGroundPose(pose);
+    }
+
+    void OccupancyGrid::setGroundPose(const glm::mat4 & pose)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->groundPose = pose;
+    }
+
+    void OccupancyGrid::setHeightRange(float minHeight, float maxHeight)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->minHeight = minHeight;
+        this->maxHeight = maxHeight;
+    }
+
+    void OccupancyGrid::setMinPoints(int minPoints)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->minPoints = std::max(minPoints, 1);
+    }
+
+    void OccupancyGrid::setMode(Mode mode, float decay)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->mode = mode;
+        this->decay = ofClamp(decay, 0.0f, 1.0f);
+    }
+
+    void OccupancyGrid::clear()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        std::fill(this->counts.begin(), this->counts.end(), 0.0f);
+        this->numFrames = 0;
+    }
+
+    void OccupancyGrid::update(const uint16_t * depthData, const Intrinsics & intrinsics, float depthScale)
+    {
+        if (!intrinsics.isValid()) return;
+
+        // Bin against a copy of the settings so snapshots only wait on the accumulation.
+        Settings settings;
+        int minPoints;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (this->counts.empty()) return;
+
+            settings.width = this->width;
+            settings.height = this->height;
+            settings.cellSize = this->cellSize;
+            settings.groundPose = this->groundPose;
+            settings.minHeight = this->minHeight;
+            settings.maxHeight = this->maxHeight;
+            minPoints = this->minPoints;
+        }
+
+        this->updateRays(intrinsics);
+
+        const int depthHeight = this->rayIntrinsics.height;
+        auto & pool = ThreadPool::getShared();
+        const int numStrips = std::max(1, std::min(pool.getConcurrency(), depthHeight / 16));
+        this->stripCells.resize(numStrips);
+        pool.parallelFor(numStrips, [&](int s)
+        {
+            this->binRows(depthData, depthScale, settings, depthHeight * s / numStrips, depthHeight * (s + 1) / numStrips, this->stripCells[s]);
+        });
+
+        const size_t numCells = size_t(settings.width) * settings.height;
+        this->frameCounts.assign(numCells, 0);
+        for (const auto & cells : this->stripCells)
+        {
+            for (auto cell : cells)
+            {
+                if (this->frameCounts[cell] < 0xFFFF)
+                {
+                    ++this->frameCounts[cell];
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        // The grid was set up again while binning.
+        if (this->counts.size() != numCells || this->width != settings.width) return;
+
+        // Mark occupied cells and fold them into the counts.
+        const float scale = (this->mode == Decayed) ? this->decay : 1.0f;
+        float * counts = this->counts.data();
+        const uint16_t * frameCounts = this->frameCounts.data();
+        size_t i = 0;
+
+#ifdef OFX_REALSENSE2_SSE2
+        const __m128 scaleVec = _mm_set1_ps(scale);
+        const __m128 one = _mm_set1_ps(1.0f);
+        // Unsigned compare through a sign flip, counts >= minPoints is counts > minPoints - 1.
+        const __m128i flip = _mm_set1_epi16((short)0x8000);
+        const __m128i threshold = _mm_xor_si128(_mm_set1_epi16((short)(minPoints - 1)), flip);
+        for (; i + 8 <= numCells; i += 8)
+        {
+            const __m128i frame = _mm_loadu_si128(reinterpret_cast<const __m128i *>(frameCounts + i));
+            const __m128i occupied = _mm_cmpgt_epi16(_mm_xor_si128(frame, flip), threshold);
+            const __m128 occupiedLow = _mm_castsi128_ps(_mm_unpacklo_epi16(occupied, occupied));
+            const __m128 occupiedHigh = _mm_castsi128_ps(_mm_unpackhi_epi16(occupied, occupied));
+
+            const __m128 low = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(counts + i), scaleVec), _mm_and_ps(occupiedLow, one));
+            const __m128 high = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(counts + i + 4), scaleVec), _mm_and_ps(occupiedHigh, one));
+            _mm_storeu_ps(counts + i, low);
+            _mm_storeu_ps(counts + i + 4, high);
+        }
+#endif
+
+        for (; i < numCells; ++i)
+        {
+            counts[i] = counts[i] * scale + ((frameCounts[i] >= minPoints) ? 1.0f : 0.0f);
+        }
+        ++this->numFrames;
+    }
+
+    void OccupancyGrid::snapshot(ofFloatPixels & pixels) const
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (pixels.getWidth() != size_t(this->width) || pixels.getHeight() != size_t(this->height) || pixels.getNumChannels() != 1)
+        {
+            pixels.allocate(this->width, this->height, OF_IMAGE_GRAYSCALE);
+        }
+        std::copy(this->counts.begin(), this->counts.end(), pixels.getData());
+    }
+
+    uint64_t OccupancyGrid::getNumFrames() const
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->numFrames;
+    }
+
+    bool OccupancyGrid::save(const std::string & path) const
+    {
+        std::vector<uint8_t> data;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+
+            FileHeader header;
+            std::memcpy(header.magic, FileMagic, sizeof(FileMagic));
+            header.width = this->width;
+            header.height = this->height;
+            header.cellSize = this->cellSize;
+            header.mode = this->mode;
+            header.decay = this->decay;
+            header.numFrames = this->numFrames;
+            data.resize(sizeof(FileHeader));
+            std::memcpy(data.data(), &header, sizeof(FileHeader));
+
+            // Each non-empty cell as the number of empty cells before it, then its count.
+            uint32_t emptyRun = 0;
+            for (float count : this->counts)
+            {
+                if (count == 0.0f)
+                {
+                    ++emptyRun;
+                    continue;
+                }
+
+                appendVarint(data, emptyRun);
+                const size_t offset = data.size();
+                data.resize(offset + sizeof(float));
+                std::memcpy(data.data() + offset, &count, sizeof(float));
+                emptyRun = 0;
+            }
+        }
+
+        ofBuffer buffer((const char *)data.data(), data.size());
+        if (!ofBufferToFile(path, buffer, true))
+        {
+            ofLogWarning(__FUNCTION__) << "Could not save occupancy grid to " << path;
+            return false;
+        }
+        return true;
+    }
+
+    bool OccupancyGrid::load(const std::string & path)
+    {
+        const ofBuffer buffer = ofBufferFromFile(path, true);
+        const uint8_t * data = (const uint8_t *)buffer.getData();
+        const uint8_t * end = data + buffer.size();
+
+        FileHeader header;
+        if (buffer.size() < sizeof(FileHeader))
+        {
+            ofLogWarning(__FUNCTION__) << "Could not read occupancy grid from " << path;
+            return false;
+        }
+        std::memcpy(&header, data, sizeof(FileHeader));
+        data += sizeof(FileHeader);
+        if (std::memcmp(header.magic, FileMagic, sizeof(FileMagic)) != 0 || header.width < 0 || header.height < 0)
+        {
+            ofLogWarning(__FUNCTION__) << "File " << path << " is not an occupancy grid";
+            return false;
+        }
+
+        std::vector<float> counts(size_t(header.width) * header.height, 0.0f);
+        size_t idx = 0;
+        while (data < end)
+        {
+            uint32_t emptyRun;
+            if (!readVarint(data, end, emptyRun) || end - data < (ptrdiff_t)sizeof(float) || idx + emptyRun >= counts.size())
+            {
+                ofLogWarning(__FUNCTION__) << "Occupancy grid " << path << " is corrupt";
+                return false;
+            }
+            idx += emptyRun;
+            std::memcpy(&counts[idx++], data, sizeof(float));
+            data += sizeof(float);
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->width = header.width;
+        this->height = header.height;
+        this->cellSize = header.cellSize;
+        this->mode = (header.mode == Decayed) ? Decayed : Cumulative;
+        this->decay = header.decay;
+        this->numFrames = header.numFrames;
+        this->counts.swap(counts);
+        return true;
+    }
+
+    void OccupancyGrid::updateRays(const Intrinsics & intrinsics)
+    {
+        const auto & native = intrinsics.getNative();
+        if (std::memcmp(&native, &this->rayIntrinsics, sizeof(rs2_intrinsics)) == 0) return;
+
+        // Padded so the SIMD loop can read a whole block past the end of a row.
+        this->rayIntrinsics = native;
+        const size_t numPixels = size_t(native.width) * native.height;
+        this->raysX.resize(numPixels + 4);
+        this->raysY.resize(numPixels + 4);
+        for (int y = 0; y < native.height; ++y)
+        {
+            for (int x = 0; x < native.width; ++x)
+            {
+                const glm::vec3 ray = intrinsics.deproject(glm::vec2(x, y), 1.0f);
+                this->raysX[size_t(y) * native.width + x] = ray.x;
+                this->raysY[size_t(y) * native.width + x] = ray.y;
+            }
+        }
+    }
+
+    void OccupancyGrid::binRows(const uint16_t * depthData, float depthScale, const Settings & settings, int y0, int y1, std::vector<uint32_t> & cells) const
+    {
+        const int depthWidth = this->rayIntrinsics.width;
+
+        // Every pixel can land in a cell, reserving for all of them keeps binning from allocating.
+        cells.clear();
+        cells.reserve(size_t(y1 - y0) * depthWidth);
+        const glm::mat4 & pose = settings.groundPose;
+        const float invCellSize = 1.0f / settings.cellSize;
+        const float offsetX = settings.width * 0.5f;
+        const float offsetY = settings.height * 0.5f;
+
+        auto binPoint = [&](float x, float y, float z)
+        {
+            const float groundX = pose[0].x * x + pose[1].x * y + pose[2].x * z + pose[3].x;
+            const float groundY = pose[0].y * x + pose[1].y * y + pose[2].y * z + pose[3].y;
+            const float groundZ = pose[0].z * x + pose[1].z * y + pose[2].z * z + pose[3].z;
+            if (groundZ < settings.minHeight || groundZ > settings.maxHeight) return;
+
+            const float cellX = groundX * invCellSize + offsetX;
+            const float cellY = groundY * invCellSize + offsetY;
+            if (cellX < 0.0f || cellY < 0.0f || cellX >= settings.width || cellY >= settings.height) return;
+
+            cells.push_back(uint32_t(cellY) * settings.width + uint32_t(cellX));
+        };
+
+        for (int y = y0; y < y1; ++y)
+        {
+            const size_t rowStart = size_t(y) * depthWidth;
+            const uint16_t * depthRow = depthData + rowStart;
+            const float * raysX = this->raysX.data() + rowStart;
+            const float * raysY = this->raysY.data() + rowStart;
+            int x = 0;
+
+#ifdef OFX_REALSENSE2_SSE2
+            const __m128 scale = _mm_set1_ps(depthScale);
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 r0 = _mm_set1_ps(pose[0].x), r1 = _mm_set1_ps(pose[1].x), r2 = _mm_set1_ps(pose[2].x), r3 = _mm_set1_ps(pose[3].x);
+            const __m128 s0 = _mm_set1_ps(pose[0].y), s1 = _mm_set1_ps(pose[1].y), s2 = _mm_set1_ps(pose[2].y), s3 = _mm_set1_ps(pose[3].y);
+            const __m128 t0 = _mm_set1_ps(pose[0].z), t1 = _mm_set1_ps(pose[1].z), t2 = _mm_set1_ps(pose[2].z), t3 = _mm_set1_ps(pose[3].z);
+            const __m128 minHeight = _mm_set1_ps(settings.minHeight);
+            const __m128 maxHeight = _mm_set1_ps(settings.maxHeight);
+            const __m128 invCell = _mm_set1_ps(invCellSize);
+            const __m128 offsetXVec = _mm_set1_ps(offsetX);
+            const __m128 offsetYVec = _mm_set1_ps(offsetY);
+            const __m128 widthVec = _mm_set1_ps((float)settings.width);
+            const __m128 heightVec = _mm_set1_ps((float)settings.height);
+            for (; x + 4 <= depthWidth; x += 4)
+            {
+                const __m128i raw = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(depthRow + x));
+                const __m128 z = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(raw, _mm_setzero_si128())), scale);
+                const __m128 px = _mm_mul_ps(_mm_loadu_ps(raysX + x), z);
+                const __m128 py = _mm_mul_ps(_mm_loadu_ps(raysY + x), z);
+
+                const __m128 groundX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r0, px), _mm_mul_ps(r1, py)), _mm_add_ps(_mm_mul_ps(r2, z), r3));
+                const __m128 groundY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(s0, px), _mm_mul_ps(s1, py)), _mm_add_ps(_mm_mul_ps(s2, z), s3));
+                const __m128 groundZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(t0, px), _mm_mul_ps(t1, py)), _mm_add_ps(_mm_mul_ps(t2, z), t3));
+                const __m128 cellX = _mm_add_ps(_mm_mul_ps(groundX, invCell), offsetXVec);
+                const __m128 cellY = _mm_add_ps(_mm_mul_ps(groundY, invCell), offsetYVec);
+
+                // Missing depth, out of the height range or off the grid.
+                __m128 valid = _mm_and_ps(_mm_cmpgt_ps(z, zero), _mm_and_ps(_mm_cmpge_ps(groundZ, minHeight), _mm_cmple_ps(groundZ, maxHeight)));
+                valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(cellX, zero), _mm_cmplt_ps(cellX, widthVec)));
+                valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(cellY, zero), _mm_cmplt_ps(cellY, heightVec)));
+                const int mask = _mm_movemask_ps(valid);
+                if (!mask) continue;
+
+                // Truncation floors the in-range cells, which are all positive.
+                alignas(16) int32_t cellsX[4];
+                alignas(16) int32_t cellsY[4];
+                _mm_store_si128(reinterpret_cast<__m128i *>(cellsX), _mm_cvttps_epi32(cellX));
+                _mm_store_si128(reinterpret_cast<__m128i *>(cellsY), _mm_cvttps_epi32(cellY));
+                for (int i = 0; i < 4; ++i)
+                {
+                    if (mask & (1 << i))
+                    {
+                        cells.push_back(uint32_t(cellsY[i]) * settings.width + uint32_t(cellsX[i]));
+                    }
+                }
+            }
+#endif
+
+            for (; x < depthWidth; ++x)
+            {
+                if (!depthRow[x]) continue;
+
+                const float z = depthRow[x] * depthScale;
+                binPoint(raysX[x] * z, raysY[x] * z, z);
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "ofPixels.h"
+#include "ofVectorMath.h"
+
+#include "Intrinsics.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ofxRealSense2
+{
+    // Long running heatmap of where things stand on the ground. Each depth frame
+    // marks the ground cells that have enough points within a height range
+    // above them, and the marks are summed over frames, optionally decaying the
+    // older ones. Memory is fixed at setup, and snapshots can be taken from
+    // another thread while frames keep coming in.
+    class OccupancyGrid
+    {
+    public:
+        enum Mode
+        {
+            Cumulative,
+            Decayed
+        };
+
+        OccupancyGrid();
+
+        // Cells are square, in meters, and the grid is centered under the camera.
+        void setup(int width, int height, float cellSize);
+        bool isAllocated() const;
+
+        // Ground plane in depth camera space, like the one from PlaneDetector.
+        void setGroundPlane(const glm::vec4 & plane);
+        // Or the full transform from depth camera space to ground space, where z is the height.
+        void setGroundPose(const glm::mat4 & pose);
+
+        // Only points between the heights (meters) count, and cells need at least minPoints.
+        void setHeightRange(float minHeight, float maxHeight);
+        void setMinPoints(int minPoints);
+
+        // Decayed mode multiplies the counts by the decay every frame.
+        void setMode(Mode mode, float decay = 0.999f);
+
+        void clear();
+
+        // Called from a single thread, usually the device worker.
+        void update(const uint16_t * depthData, const Intrinsics & intrinsics, float depthScale);
+
+        // Copies the counts into a single channel image, one pixel per cell.
+        void snapshot(ofFloatPixels & pixels) const;
+        uint64_t getNumFrames() const;
+
+        // Saves the counts with their setup, runs of empty cells are stored as a length.
+        bool save(const std::string & path) const;
+        bool load(const std::string & path);
+
+    private:
+        struct Settings
+        {
+            int width;
+            int height;
+            float cellSize;
+            glm::mat4 groundPose;
+            float minHeight;
+            float maxHeight;
+        };
+
+        void updateRays(const Intrinsics & intrinsics);
+        void binRows(const uint16_t * depthData, float depthScale, const Settings & settings, int y0, int y1, std::vector<uint32_t> & cells) const;
+
+    private:
+        mutable std::mutex mutex;
+
+        int width;
+        int height;
+        float cellSize;
+        glm::mat4 groundPose;
+        float minHeight;
+        float maxHeight;
+        int minPoints;
+        Mode mode;
+        float decay;
+
+        std::vector<float> counts;
+        uint64_t numFrames;
+
+        // Only touched by update().
+        std::vector<uint16_t> frameCounts;
+        std::vector<std::vector<uint32_t>> stripCells;
+
+        // Depth pixel rays at unit depth, one array per axis.
+        std::vector<float> raysX;
+        std::vector<float> raysY;
+        rs2_intrinsics rayIntrinsics;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "OptionMonitor.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace ofxRealSense2
+{
+    OptionMonitor::OptionMonitor()
+    {
+        for (auto & slot : this->slots)
+        {
+            slot.numSamples = 0;
+            slot.value = std::numeric_limits<float>::quiet_NaN();
+            for (auto & value : slot.history)
+            {
+                value = 0.0f;
+            }
+        }
+    }
+
+    void OptionMonitor::record(rs2_option option, float value)
+    {
+        if (option < 0 || option >= RS2_OPTION_COUNT) return;
+
+        auto & slot = this->slots[option];
+        const uint64_t numSamples = slot.numSamples.load(std::memory_order_relaxed);
+        slot.history[numSamples % HistorySize].store(value, std::memory_order_relaxed);
+        slot.value.store(value, std::memory_order_relaxed);
+        slot.numSamples.store(numSamples + 1, std::memory_order_release);
+    }
+
+    float OptionMonitor::getValue(rs2_option option) const
+    {
+        if (option < 0 || option >= RS2_OPTION_COUNT) return std::numeric_limits<float>::quiet_NaN();
+
+        return this->slots[option].value.load(std::memory_order_relaxed);
+    }
+
+    size_t OptionMonitor::getHistory(rs2_option option, std::vector<float> & values) const
+    {
+        values.clear();
+        if (option < 0 || option >= RS2_OPTION_COUNT) return 0;
+
+        const auto & slot = this->slots[option];
+        const uint64_t numSamples = slot.numSamples.load(std::memory_order_acquire);
+        const uint64_t numValues = std::min<uint64_t>(numSamples, HistorySize);
+        for (uint64_t i = numSamples - numValues; i < numSamples; ++i)
+        {
+            values.push_back(slot.history[i % HistorySize].load(std::memory_order_relaxed));
+        }
+        return values.size();
+    }
+
+    uint64_t OptionMonitor::getNumSamples(rs2_option option) const
+    {
+        if (option < 0 || option >= RS2_OPTION_COUNT) return 0;
+
+        return this->slots[option].numSamples.load(std::memory_order_acquire);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "librealsense2/rs.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace ofxRealSense2
+{
+    // Latest values and recent history of polled sensor options, one fixed slot
+    // per option. A single thread records values, any thread can read them
+    // without locking. A history read racing a record may see the newer value.
+    class OptionMonitor
+    {
+    public:
+        static const size_t HistorySize = 64;
+
+        OptionMonitor();
+
+        void record(rs2_option option, float value);
+
+        // NaN if the option hasn't been polled.
+        float getValue(rs2_option option) const;
+        // Replaces the output with the recent values, oldest first.
+        size_t getHistory(rs2_option option, std::vector<float> & values) const;
+        uint64_t getNumSamples(rs2_option option) const;
+
+    private:
+        struct Slot
+        {
+            std::atomic<uint64_t> numSamples;
+            std::atomic<float> value;
+            std::array<std::atomic<float>, HistorySize> history;
+        };
+
+        std::array<Slot, RS2_OPTION_COUNT> slots;
+    };
+}
\ No newline at end of file
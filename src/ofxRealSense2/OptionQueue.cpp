@@ -0,0 +1,125 @@
+#include "OptionQueue.h"
+
+namespace ofxRealSense2
+{
+    OptionQueue::OptionQueue()
+        : numPending(0)
+        , stopping(false)
+    {
+        const Command empty = { false, 0.0f, std::chrono::steady_clock::time_point() };
+        this->pending.fill(empty);
+        this->applying.fill(empty);
+        this->applied.reserve(RS2_OPTION_COUNT);
+        this->results.reserve(RS2_OPTION_COUNT);
+    }
+
+    OptionQueue::~OptionQueue()
+    {
+        this->stop();
+    }
+
+    void OptionQueue::start(const rs2::sensor & sensor)
+    {
+        this->stop();
+
+        this->sensor = sensor;
+        this->stopping = false;
+        this->thread = std::thread(&OptionQueue::threadLoop, this);
+    }
+
+    void OptionQueue::stop()
+    {
+        if (!this->thread.joinable()) return;
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->condition.notify_all();
+        this->thread.join();
+    }
+
+    bool OptionQueue::isRunning() const
+    {
+        return this->thread.joinable();
+    }
+
+    void OptionQueue::post(rs2_option option, float value)
+    {
+        if (option < 0 || option >= RS2_OPTION_COUNT) return;
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            auto & command = this->pending[option];
+            if (!command.posted)
+            {
+                command.posted = true;
+                ++this->numPending;
+            }
+            command.value = value;
+            command.postTime = std::chrono::steady_clock::now();
+        }
+        this->condition.notify_one();
+    }
+
+    void OptionQueue::takeResults(std::vector<OptionResult> & results)
+    {
+        // Copied rather than swapped, so both vectors keep their capacity.
+        std::lock_guard<std::mutex> lock(this->mutex);
+        results.assign(this->results.begin(), this->results.end());
+        this->results.clear();
+    }
+
+    void OptionQueue::threadLoop()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while (true)
+        {
+            this->condition.wait(lock, [this]
+            {
+                return this->stopping || this->numPending > 0;
+            });
+            if (this->numPending == 0) return;
+
+            // Take everything posted so far, later posts wait for the next round.
+            this->applying.swap(this->pending);
+            this->numPending = 0;
+            lock.unlock();
+
+            this->applied.clear();
+            for (int i = 0; i < RS2_OPTION_COUNT; ++i)
+            {
+                auto & command = this->applying[i];
+                if (!command.posted) continue;
+                command.posted = false;
+
+                const auto option = (rs2_option)i;
+                OptionResult result;
+                result.option = option;
+                result.value = command.value;
+                result.success = false;
+                try
+                {
+                    if (this->sensor.supports(option))
+                    {
+                        this->sensor.set_option(option, command.value);
+                        result.success = true;
+                    }
+                    else
+                    {
+                        result.error = std::string(rs2_option_to_string(option)) + " is not supported";
+                    }
+                }
+                catch (rs2::error & e)
+                {
+                    result.error = e.what();
+                }
+                result.latency = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - command.postTime).count();
+                this->applied.push_back(result);
+            }
+
+            lock.lock();
+            this->results.insert(this->results.end(), this->applied.begin(), this->applied.end());
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "librealsense2/rs.hpp"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ofxRealSense2
+{
+    struct OptionResult
+    {
+        rs2_option option;
+        float value;
+        bool success;
+        // Milliseconds from posting the value to the sensor accepting it.
+        float latency;
+        std::string error;
+    };
+
+    // Writes sensor options on a background thread, since every write is a
+    // blocking USB control transfer. Writes are coalesced per option, so while
+    // one is in flight only the latest value posted for each option is kept.
+    // Every option has a fixed slot, posting never allocates.
+    class OptionQueue
+    {
+    public:
+        OptionQueue();
+        ~OptionQueue();
+
+        void start(const rs2::sensor & sensor);
+        // Applies what is still pending, then stops the thread.
+        void stop();
+        bool isRunning() const;
+
+        void post(rs2_option option, float value);
+
+        // Moves the results gathered since the last call into the output.
+        void takeResults(std::vector<OptionResult> & results);
+
+    private:
+        struct Command
+        {
+            bool posted;
+            float value;
+            std::chrono::steady_clock::time_point postTime;
+        };
+        typedef std::array<Command, RS2_OPTION_COUNT> Commands;
+
+        void threadLoop();
+
+    private:
+        rs2::sensor sensor;
+        std::thread thread;
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        Commands pending;
+        Commands applying;
+        int numPending;
+        std::vector<OptionResult> applied;
+        std::vector<OptionResult> results;
+        bool stopping;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,341 @@
+#include "PlaneDetector.h"
+
+#include "Simd.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace ofxRealSense2
+{
+    namespace
+    {
+        // Tracking re-fits the previous plane as long as it keeps this share of its inliers.
+        const float TrackingRatio = 0.8f;
+
+        // Eigenvector of the smallest eigenvalue of a symmetric 3x3 matrix, with Jacobi rotations.
+        glm::vec3 getSmallestEigenvector(double m[3][3])
+        {
+            double v[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+            for (int sweep = 0; sweep < 16; ++sweep)
+            {
+                const double offDiagonal = std::fabs(m[0][1]) + std::fabs(m[0][2]) + std::fabs(m[1][2]);
+                if (offDiagonal < 1e-15) break;
+
+                for (int p = 0; p < 2; ++p)
+                {
+                    for (int q = p + 1; q < 3; ++q)
+                    {
+                        if (std::fabs(m[p][q]) < 1e-30) continue;
+
+                        const double theta = (m[q][q] - m[p][p]) / (2.0 * m[p][q]);
+                        const double t = ((theta >= 0.0) ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+                        const double c = 1.0 / std::sqrt(t * t + 1.0);
+                        const double s = t * c;
+                        for (int k = 0; k < 3; ++k)
+                        {
+                            const double mkp = m[k][p];
+                            const double mkq = m[k][q];
+                            m[k][p] = c * mkp - s * mkq;
+                            m[k][q] = s * mkp + c * mkq;
+                        }
+                        for (int k = 0; k < 3; ++k)
+                        {
+                            const double mpk = m[p][k];
+                            const double mqk = m[q][k];
+                            m[p][k] = c * mpk - s * mqk;
+                            m[q][k] = s * mpk + c * mqk;
+                        }
+                        for (int k = 0; k < 3; ++k)
+                        {
+                            const double vkp = v[k][p];
+                            const double vkq = v[k][q];
+                            v[k][p] = c * vkp - s * vkq;
+                            v[k][q] = s * vkp + c * vkq;
+                        }
+                    }
+                }
+            }
+
+            int smallest = 0;
+            for (int i = 1; i < 3; ++i)
+            {
+                if (m[i][i] < m[smallest][smallest])
+                {
+                    smallest = i;
+                }
+            }
+            return glm::vec3((float)v[0][smallest], (float)v[1][smallest], (float)v[2][smallest]);
+        }
+    }
+
+    PlaneDetector::PlaneDetector()
+        : step(4)
+        , threshold(0.02f)
+        , numHypotheses(128)
+        , constraintNormal(0.0f)
+        , constraintCosine(-1.0f)
+        , numPoints(0)
+        , seed(0)
+        , valid(false)
+        , tracked(false)
+        , plane(0.0f)
+        , numInliers(0)
+    {
+
+    }
+
+    void PlaneDetector::setStep(int step)
+    {
+        this->step = std::max(step, 1);
+    }
+
+    void PlaneDetector::setThreshold(float threshold)
+    {
+        this->threshold = threshold;
+    }
+
+    void PlaneDetector::setNumHypotheses(int numHypotheses)
+    {
+        this->numHypotheses = std::max(numHypotheses, 1);
+    }
+
+    void PlaneDetector::setNormalConstraint(const glm::vec3 & normal, float maxAngle)
+    {
+        const float length = glm::length(normal);
+        this->constraintNormal = (length > 0.0f) ? normal / length : glm::vec3(0.0f);
+        this->constraintCosine = (length > 0.0f) ? std::cos(glm::radians(maxAngle)) : -1.0f;
+        this->reset();
+    }
+
+    void PlaneDetector::reset()
+    {
+        this->valid = false;
+        this->tracked = false;
+        this->numInliers = 0;
+    }
+
+    bool PlaneDetector::update(const uint16_t * depthData, const Intrinsics & intrinsics, float depthScale)
+    {
+        this->tracked = false;
+        if (!intrinsics.isValid())
+        {
+            this->valid = false;
+            return false;
+        }
+
+        // Subsample into per-axis arrays, padded to a multiple of 4 for the SIMD loop.
+        const int width = intrinsics.getWidth();
+        const int height = intrinsics.getHeight();
+        const size_t maxPoints = size_t((width + this->step - 1) / this->step) * ((height + this->step - 1) / this->step) + 4;
+        this->pointsX.resize(maxPoints);
+        this->pointsY.resize(maxPoints);
+        this->pointsZ.resize(maxPoints);
+        int count = 0;
+        for (int y = 0; y < height; y += this->step)
+        {
+            for (int x = 0; x < width; x += this->step)
+            {
+                const uint16_t rawDepth = depthData[size_t(y) * width + x];
+                if (!rawDepth) continue;
+
+                const glm::vec3 point = intrinsics.deproject(glm::vec2(x, y), rawDepth * depthScale);
+                this->pointsX[count] = point.x;
+                this->pointsY[count] = point.y;
+                this->pointsZ[count] = point.z;
+                ++count;
+            }
+        }
+        this->numPoints = count;
+        // NaN padding never passes the inlier test.
+        for (int i = count; i < ((count + 3) & ~3); ++i)
+        {
+            this->pointsX[i] = this->pointsY[i] = this->pointsZ[i] = std::numeric_limits<float>::quiet_NaN();
+        }
+        if (count < 3)
+        {
+            this->valid = false;
+            return false;
+        }
+
+        // Keep following the previous plane while it still fits.
+        if (this->valid)
+        {
+            glm::vec4 candidate = this->plane;
+            int candidateInliers = this->countInliers(candidate);
+            if (candidateInliers >= this->numInliers * TrackingRatio && this->refine(candidate, candidateInliers))
+            {
+                this->plane = candidate;
+                this->numInliers = candidateInliers;
+                this->tracked = true;
+                return true;
+            }
+        }
+
+        // Sample hypotheses up front so scoring is deterministic across thread counts.
+        std::minstd_rand random(++this->seed);
+        std::uniform_int_distribution<int> pick(0, count - 1);
+        this->hypotheses.resize(this->numHypotheses);
+        this->scores.resize(this->numHypotheses);
+        for (auto & hypothesis : this->hypotheses)
+        {
+            const int a = pick(random);
+            const int b = pick(random);
+            const int c = pick(random);
+            const glm::vec3 pa(this->pointsX[a], this->pointsY[a], this->pointsZ[a]);
+            const glm::vec3 pb(this->pointsX[b], this->pointsY[b], this->pointsZ[b]);
+            const glm::vec3 pc(this->pointsX[c], this->pointsY[c], this->pointsZ[c]);
+            const glm::vec3 normal = glm::cross(pb - pa, pc - pa);
+            const float length = glm::length(normal);
+
+            // Degenerate samples or planes out of the constraint get no score.
+            hypothesis = glm::vec4(0.0f);
+            if (length < 1e-6f) continue;
+
+            const glm::vec3 unit = normal / length;
+            if (this->constraintCosine > -1.0f && std::fabs(glm::dot(unit, this->constraintNormal)) < this->constraintCosine) continue;
+
+            hypothesis = glm::vec4(unit, -glm::dot(unit, pa));
+        }
+
+        ThreadPool::getShared().parallelFor(this->numHypotheses, [this](int idx)
+        {
+            const auto & hypothesis = this->hypotheses[idx];
+            this->scores[idx] = (hypothesis.x == 0.0f && hypothesis.y == 0.0f && hypothesis.z == 0.0f) ? 0 : this->countInliers(hypothesis);
+        });
+
+        const int best = int(std::max_element(this->scores.begin(), this->scores.end()) - this->scores.begin());
+        glm::vec4 candidate = this->hypotheses[best];
+        int candidateInliers = this->scores[best];
+        this->valid = candidateInliers >= 3 && this->refine(candidate, candidateInliers);
+        if (this->valid)
+        {
+            this->plane = candidate;
+            this->numInliers = candidateInliers;
+        }
+        return this->valid;
+    }
+
+    bool PlaneDetector::isValid() const
+    {
+        return this->valid;
+    }
+
+    const glm::vec4 & PlaneDetector::getPlane() const
+    {
+        return this->plane;
+    }
+
+    float PlaneDetector::getHeight(const glm::vec3 & point) const
+    {
+        return glm::dot(glm::vec3(this->plane), point) + this->plane.w;
+    }
+
+    int PlaneDetector::getNumInliers() const
+    {
+        return this->numInliers;
+    }
+
+    int PlaneDetector::getNumPoints() const
+    {
+        return this->numPoints;
+    }
+
+    bool PlaneDetector::wasTracked() const
+    {
+        return this->tracked;
+    }
+
+    int PlaneDetector::countInliers(const glm::vec4 & plane) const
+    {
+        const float * xs = this->pointsX.data();
+        const float * ys = this->pointsY.data();
+        const float * zs = this->pointsZ.data();
+        int count = 0;
+        int i = 0;
+
+#ifdef OFX_REALSENSE2_SSE2
+        const __m128 a = _mm_set1_ps(plane.x);
+        const __m128 b = _mm_set1_ps(plane.y);
+        const __m128 c = _mm_set1_ps(plane.z);
+        const __m128 d = _mm_set1_ps(plane.w);
+        const __m128 threshold = _mm_set1_ps(this->threshold);
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        __m128i counts = _mm_setzero_si128();
+        // The padding points never count, so the last block can overrun.
+        for (; i < this->numPoints; i += 4)
+        {
+            const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, _mm_loadu_ps(xs + i)), _mm_mul_ps(b, _mm_loadu_ps(ys + i))),
+                _mm_add_ps(_mm_mul_ps(c, _mm_loadu_ps(zs + i)), d));
+            // Inlier lanes are all ones, which is -1.
+            counts = _mm_sub_epi32(counts, _mm_castps_si128(_mm_cmplt_ps(_mm_and_ps(distance, absMask), threshold)));
+        }
+        alignas(16) int32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), counts);
+        count = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+
+        for (; i < this->numPoints; ++i)
+        {
+            if (std::fabs(plane.x * xs[i] + plane.y * ys[i] + plane.z * zs[i] + plane.w) < this->threshold)
+            {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    bool PlaneDetector::refine(glm::vec4 & plane, int & numInliers) const
+    {
+        // Least squares fit to the inliers, twice since the inliers move with the plane.
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            double sum[3] = {};
+            double products[3][3] = {};
+            int count = 0;
+            for (int i = 0; i < this->numPoints; ++i)
+            {
+                const double p[3] = { this->pointsX[i], this->pointsY[i], this->pointsZ[i] };
+                if (std::fabs(plane.x * p[0] + plane.y * p[1] + plane.z * p[2] + plane.w) >= this->threshold) continue;
+
+                for (int r = 0; r < 3; ++r)
+                {
+                    sum[r] += p[r];
+                    for (int c = r; c < 3; ++c)
+                    {
+                        products[r][c] += p[r] * p[c];
+                    }
+                }
+                ++count;
+            }
+            if (count < 3) return false;
+
+            double covariance[3][3];
+            for (int r = 0; r < 3; ++r)
+            {
+                for (int c = r; c < 3; ++c)
+                {
+                    covariance[r][c] = covariance[c][r] = products[r][c] / count - (sum[r] / count) * (sum[c] / count);
+                }
+            }
+
+            glm::vec3 normal = getSmallestEigenvector(covariance);
+            const glm::vec3 centroid((float)(sum[0] / count), (float)(sum[1] / count), (float)(sum[2] / count));
+            if (this->constraintCosine > -1.0f && std::fabs(glm::dot(normal, this->constraintNormal)) < this->constraintCosine) return false;
+
+            // Face the camera, which sits at the origin.
+            float distance = -glm::dot(normal, centroid);
+            if (distance < 0.0f)
+            {
+                normal = -normal;
+                distance = -distance;
+            }
+            plane = glm::vec4(normal, distance);
+        }
+
+        numInliers = this->countInliers(plane);
+        return numInliers >= 3;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ofVectorMath.h"
+
+#include "Intrinsics.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace ofxRealSense2
+{
+    // Finds the dominant plane in a depth frame, like a floor or table top, with
+    // RANSAC over subsampled points and a least squares refinement of the inliers.
+    // Once found, later frames first re-fit the previous plane and only search
+    // again if it lost too many inliers, so the plane can be tracked every frame.
+    // Planes are in depth camera space, with the normal facing the camera.
+    class PlaneDetector
+    {
+    public:
+        PlaneDetector();
+
+        // Uses every step pixels in both directions.
+        void setStep(int step);
+        // Points closer to the plane than this (meters) are inliers.
+        void setThreshold(float threshold);
+        void setNumHypotheses(int numHypotheses);
+        // Only accepts planes whose normal is within the angle (degrees) of the
+        // direction, like the camera's up vector for a floor. A zero direction accepts any.
+        void setNormalConstraint(const glm::vec3 & normal, float maxAngle);
+
+        // Forgets the tracked plane, the next update searches from scratch.
+        void reset();
+
+        // Returns true if a plane was found.
+        bool update(const uint16_t * depthData, const Intrinsics & intrinsics, float depthScale);
+
+        bool isValid() const;
+        // (normal, distance), where dot(normal, point) + distance is the signed height.
+        const glm::vec4 & getPlane() const;
+        float getHeight(const glm::vec3 & point) const;
+
+        int getNumInliers() const;
+        int getNumPoints() const;
+        // True if the last update re-fit the tracked plane without searching.
+        bool wasTracked() const;
+
+    private:
+        int countInliers(const glm::vec4 & plane) const;
+        bool refine(glm::vec4 & plane, int & numInliers) const;
+
+    private:
+        int step;
+        float threshold;
+        int numHypotheses;
+        glm::vec3 constraintNormal;
+        float constraintCosine;
+
+        // Subsampled points, one array per axis.
+        std::vector<float> pointsX;
+        std::vector<float> pointsY;
+        std::vector<float> pointsZ;
+        int numPoints;
+
+        std::vector<glm::vec4> hypotheses;
+        std::vector<int> scores;
+        uint32_t seed;
+
+        bool valid;
+        bool tracked;
+        glm::vec4 plane;
+        int numInliers;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,278 @@
+#include "RegionStats.h"
+
+#include "Simd.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ofxRealSense2
+{
+    RegionStats::RegionStats()
+        : width(0)
+        , height(0)
+        , depthScale(0.001f)
+        , zoneSize(0)
+        , zonesX(0)
+        , zonesY(0)
+        , maxDistance(0.0f)
+    {
+
+    }
+
+    void RegionStats::update(const uint16_t * depthData, int width, int height, float depthScale, int zoneSize, float maxDistance)
+    {
+        this->width = width;
+        this->height = height;
+        this->depthScale = depthScale;
+
+        const int stride = width + 1;
+        const size_t numEntries = size_t(stride) * (height + 1);
+        this->sums.resize(numEntries);
+        this->squareSums.resize(numEntries);
+        this->counts.resize(numEntries);
+
+        std::fill(this->sums.begin(), this->sums.begin() + stride, 0);
+        std::fill(this->squareSums.begin(), this->squareSums.begin() + stride, 0);
+        std::fill(this->counts.begin(), this->counts.begin() + stride, 0);
+
+        for (int y = 0; y < height; ++y)
+        {
+            const uint16_t * depthRow = depthData + size_t(y) * width;
+            uint64_t * sumRow = this->sums.data() + size_t(y + 1) * stride;
+            uint64_t * squareSumRow = this->squareSums.data() + size_t(y + 1) * stride;
+            uint32_t * countRow = this->counts.data() + size_t(y + 1) * stride;
+
+            // Running sums along the row.
+            uint64_t sum = 0;
+            uint64_t squareSum = 0;
+            uint32_t count = 0;
+            sumRow[0] = squareSumRow[0] = countRow[0] = 0;
+            for (int x = 0; x < width; ++x)
+            {
+                const uint32_t depth = depthRow[x];
+                sum += depth;
+                squareSum += depth * depth;
+                count += depth != 0;
+                sumRow[x + 1] = sum;
+                squareSumRow[x + 1] = squareSum;
+                countRow[x + 1] = count;
+            }
+
+            // Add the row above.
+            const uint64_t * sumAbove = sumRow - stride;
+            const uint64_t * squareSumAbove = squareSumRow - stride;
+            const uint32_t * countAbove = countRow - stride;
+            int x = 1;
+#ifdef OFX_REALSENSE2_SSE2
+            for (; x + 4 <= stride; x += 4)
+            {
+                for (int k = 0; k < 4; k += 2)
+                {
+                    __m128i * sumDst = reinterpret_cast<__m128i *>(sumRow + x + k);
+                    __m128i * squareSumDst = reinterpret_cast<__m128i *>(squareSumRow + x + k);
+                    _mm_storeu_si128(sumDst, _mm_add_epi64(_mm_loadu_si128(sumDst), _mm_loadu_si128(reinterpret_cast<const __m128i *>(sumAbove + x + k))));
+                    _mm_storeu_si128(squareSumDst, _mm_add_epi64(_mm_loadu_si128(squareSumDst), _mm_loadu_si128(reinterpret_cast<const __m128i *>(squareSumAbove + x + k))));
+                }
+                __m128i * countDst = reinterpret_cast<__m128i *>(countRow + x);
+                _mm_storeu_si128(countDst, _mm_add_epi32(_mm_loadu_si128(countDst), _mm_loadu_si128(reinterpret_cast<const __m128i *>(countAbove + x))));
+            }
+#endif
+            for (; x < stride; ++x)
+            {
+                sumRow[x] += sumAbove[x];
+                squareSumRow[x] += squareSumAbove[x];
+                countRow[x] += countAbove[x];
+            }
+        }
+
+        this->zoneSize = zoneSize;
+        this->maxDistance = maxDistance;
+        if (zoneSize <= 0 || maxDistance <= 0.0f)
+        {
+            this->zoneSize = this->zonesX = this->zonesY = 0;
+            this->histograms.clear();
+            return;
+        }
+
+        this->zonesX = (width + zoneSize - 1) / zoneSize;
+        this->zonesY = (height + zoneSize - 1) / zoneSize;
+        const int zoneStride = this->zonesX + 1;
+        this->histograms.assign(size_t(zoneStride) * (this->zonesY + 1) * NumBins, 0);
+
+        // Fill each zone histogram, one zone row per job.
+        const float binScale = NumBins * depthScale / maxDistance;
+        ThreadPool::getShared().parallelFor(this->zonesY, [&](int zy)
+        {
+            const int y0 = zy * zoneSize;
+            const int y1 = std::min(y0 + zoneSize, height);
+            for (int y = y0; y < y1; ++y)
+            {
+                const uint16_t * depthRow = depthData + size_t(y) * width;
+                for (int x = 0; x < width; ++x)
+                {
+                    if (!depthRow[x]) continue;
+
+                    const int bin = std::min((int)(depthRow[x] * binScale), NumBins - 1);
+                    const size_t zone = size_t(zy + 1) * zoneStride + (x / zoneSize + 1);
+                    ++this->histograms[zone * NumBins + bin];
+                }
+            }
+        });
+
+        // Sum the zones, all bins at once.
+        for (int zy = 1; zy <= this->zonesY; ++zy)
+        {
+            for (int zx = 1; zx <= this->zonesX; ++zx)
+            {
+                uint32_t * hist = this->histograms.data() + (size_t(zy) * zoneStride + zx) * NumBins;
+                const uint32_t * left = hist - NumBins;
+                const uint32_t * above = hist - size_t(zoneStride) * NumBins;
+                const uint32_t * aboveLeft = above - NumBins;
+                int b = 0;
+#ifdef OFX_REALSENSE2_SSE2
+                for (; b + 4 <= NumBins; b += 4)
+                {
+                    __m128i sum = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hist + b));
+                    sum = _mm_add_epi32(sum, _mm_loadu_si128(reinterpret_cast<const __m128i *>(left + b)));
+                    sum = _mm_add_epi32(sum, _mm_loadu_si128(reinterpret_cast<const __m128i *>(above + b)));
+                    sum = _mm_sub_epi32(sum, _mm_loadu_si128(reinterpret_cast<const __m128i *>(aboveLeft + b)));
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(hist + b), sum);
+                }
+#endif
+                for (; b < NumBins; ++b)
+                {
+                    hist[b] += left[b] + above[b] - aboveLeft[b];
+                }
+            }
+        }
+    }
+
+    void RegionStats::swap(RegionStats & other)
+    {
+        std::swap(this->width, other.width);
+        std::swap(this->height, other.height);
+        std::swap(this->depthScale, other.depthScale);
+        this->sums.swap(other.sums);
+        this->squareSums.swap(other.squareSums);
+        this->counts.swap(other.counts);
+        std::swap(this->zoneSize, other.zoneSize);
+        std::swap(this->zonesX, other.zonesX);
+        std::swap(this->zonesY, other.zonesY);
+        std::swap(this->maxDistance, other.maxDistance);
+        this->histograms.swap(other.histograms);
+    }
+
+    bool RegionStats::isAllocated() const
+    {
+        return this->width > 0 && this->height > 0;
+    }
+
+    int RegionStats::getWidth() const
+    {
+        return this->width;
+    }
+
+    int RegionStats::getHeight() const
+    {
+        return this->height;
+    }
+
+    int RegionStats::getCount(const ofRectangle & rect) const
+    {
+        int x0, y0, x1, y1;
+        if (!this->clip(rect, x0, y0, x1, y1)) return 0;
+
+        const int stride = this->width + 1;
+        const auto & c = this->counts;
+        return c[y1 * stride + x1] - c[y0 * stride + x1] - c[y1 * stride + x0] + c[y0 * stride + x0];
+    }
+
+    float RegionStats::getMean(const ofRectangle & rect) const
+    {
+        int x0, y0, x1, y1;
+        if (!this->clip(rect, x0, y0, x1, y1)) return 0.0f;
+
+        const int stride = this->width + 1;
+        const auto & c = this->counts;
+        const auto & s = this->sums;
+        const uint32_t count = c[y1 * stride + x1] - c[y0 * stride + x1] - c[y1 * stride + x0] + c[y0 * stride + x0];
+        if (!count) return 0.0f;
+
+        const uint64_t sum = s[y1 * stride + x1] - s[y0 * stride + x1] - s[y1 * stride + x0] + s[y0 * stride + x0];
+        return (float)((double)sum / count * this->depthScale);
+    }
+
+    float RegionStats::getVariance(const ofRectangle & rect) const
+    {
+        int x0, y0, x1, y1;
+        if (!this->clip(rect, x0, y0, x1, y1)) return 0.0f;
+
+        const int stride = this->width + 1;
+        const auto & c = this->counts;
+        const auto & s = this->sums;
+        const auto & q = this->squareSums;
+        const uint32_t count = c[y1 * stride + x1] - c[y0 * stride + x1] - c[y1 * stride + x0] + c[y0 * stride + x0];
+        if (!count) return 0.0f;
+
+        const uint64_t sum = s[y1 * stride + x1] - s[y0 * stride + x1] - s[y1 * stride + x0] + s[y0 * stride + x0];
+        const uint64_t squareSum = q[y1 * stride + x1] - q[y0 * stride + x1] - q[y1 * stride + x0] + q[y0 * stride + x0];
+        const double mean = (double)sum / count;
+        const double variance = std::max((double)squareSum / count - mean * mean, 0.0);
+        return (float)(variance * this->depthScale * this->depthScale);
+    }
+
+    float RegionStats::getDeviation(const ofRectangle & rect) const
+    {
+        return std::sqrt(this->getVariance(rect));
+    }
+
+    float RegionStats::getMedian(const ofRectangle & rect) const
+    {
+        int x0, y0, x1, y1;
+        if (!this->zoneSize || !this->clip(rect, x0, y0, x1, y1)) return 0.0f;
+
+        // Grow to the overlapped zones.
+        const int zx0 = x0 / this->zoneSize;
+        const int zy0 = y0 / this->zoneSize;
+        const int zx1 = (x1 + this->zoneSize - 1) / this->zoneSize;
+        const int zy1 = (y1 + this->zoneSize - 1) / this->zoneSize;
+
+        const size_t zoneStride = this->zonesX + 1;
+        const uint32_t * h00 = this->histograms.data() + (zy0 * zoneStride + zx0) * NumBins;
+        const uint32_t * h01 = this->histograms.data() + (zy0 * zoneStride + zx1) * NumBins;
+        const uint32_t * h10 = this->histograms.data() + (zy1 * zoneStride + zx0) * NumBins;
+        const uint32_t * h11 = this->histograms.data() + (zy1 * zoneStride + zx1) * NumBins;
+
+        uint32_t total = 0;
+        for (int b = 0; b < NumBins; ++b)
+        {
+            total += h11[b] - h01[b] - h10[b] + h00[b];
+        }
+        if (!total) return 0.0f;
+
+        // Walk to the middle sample and interpolate within its bin.
+        const float half = total * 0.5f;
+        uint32_t below = 0;
+        for (int b = 0; b < NumBins; ++b)
+        {
+            const uint32_t count = h11[b] - h01[b] - h10[b] + h00[b];
+            if (below + count >= half)
+            {
+                const float fraction = count ? (half - below) / count : 0.0f;
+                return (b + fraction) * this->maxDistance / NumBins;
+            }
+            below += count;
+        }
+        return this->maxDistance;
+    }
+
+    bool RegionStats::clip(const ofRectangle & rect, int & x0, int & y0, int & x1, int & y1) const
+    {
+        x0 = std::max(0, (int)std::floor(rect.x));
+        y0 = std::max(0, (int)std::floor(rect.y));
+        x1 = std::min(this->width, (int)std::ceil(rect.x + rect.width));
+        y1 = std::min(this->height, (int)std::ceil(rect.y + rect.height));
+        return x0 < x1 && y0 < y1;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "ofRectangle.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace ofxRealSense2
+{
+    // Summed-area tables of raw depth (sum, sum of squares and valid count) for
+    // constant time mean and variance over any rectangle. Optionally also keeps
+    // depth histograms per square zone, summed over zones as well, for an
+    // approximate median at zone resolution. Results are in meters and pixels
+    // without depth are ignored.
+    class RegionStats
+    {
+    public:
+        static const int NumBins = 256;
+
+        RegionStats();
+
+        // A zone size of 0 skips the histograms.
+        void update(const uint16_t * depthData, int width, int height, float depthScale, int zoneSize, float maxDistance);
+        void swap(RegionStats & other);
+
+        bool isAllocated() const;
+        int getWidth() const;
+        int getHeight() const;
+
+        int getCount(const ofRectangle & rect) const;
+        float getMean(const ofRectangle & rect) const;
+        float getVariance(const ofRectangle & rect) const;
+        float getDeviation(const ofRectangle & rect) const;
+
+        // Uses the zones the rectangle overlaps, returns 0 without histograms or depth.
+        float getMedian(const ofRectangle & rect) const;
+
+    private:
+        bool clip(const ofRectangle & rect, int & x0, int & y0, int & x1, int & y1) const;
+
+    private:
+        int width;
+        int height;
+        float depthScale;
+
+        // (width + 1) * (height + 1) entries, with a zero first row and column.
+        std::vector<uint64_t> sums;
+        std::vector<uint64_t> squareSums;
+        std::vector<uint32_t> counts;
+
+        int zoneSize;
+        int zonesX;
+        int zonesY;
+        float maxDistance;
+        // NumBins per entry, (zonesX + 1) * (zonesY + 1) entries.
+        std::vector<uint32_t> histograms;
+    };
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+// SSE2 is part of the x86-64 baseline, so it is used whenever the target is x86.
+// Kernels keep a scalar path for other architectures and for remainder pixels.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OFX_REALSENSE2_SSE2 1
+#include <emmintrin.h>
+#endif
\ No newline at end of file
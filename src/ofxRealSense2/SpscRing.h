@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace ofxRealSense2
+{
+    // Lock-free ring for exactly one producer thread and one consumer thread.
+    // Items are copied in and out, so keep them small. When the ring is full
+    // new items are dropped, the consumer is expected to drain it regularly.
+    template<typename T, size_t Capacity>
+    class SpscRing
+    {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+    public:
+        SpscRing()
+            : head(0)
+            , tail(0)
+        {}
+
+        // Producer side, returns false if the ring is full.
+        bool push(const T & item)
+        {
+            const size_t head = this->head.load(std::memory_order_relaxed);
+            if (head - this->tail.load(std::memory_order_acquire) == Capacity) return false;
+
+            this->items[head & (Capacity - 1)] = item;
+            this->head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side, moves up to count items to the output and returns how many.
+        size_t pop(T * items, size_t count)
+        {
+            const size_t tail = this->tail.load(std::memory_order_relaxed);
+            const size_t numItems = std::min(count, this->head.load(std::memory_order_acquire) - tail);
+            for (size_t i = 0; i < numItems; ++i)
+            {
+                items[i] = this->items[(tail + i) & (Capacity - 1)];
+            }
+            this->tail.store(tail + numItems, std::memory_order_release);
+            return numItems;
+        }
+
+        // Consumer side.
+        void clear()
+        {
+            this->tail.store(this->head.load(std::memory_order_acquire), std::memory_order_release);
+        }
+
+    private:
+        // Kept on separate cache lines so the two threads don't contend.
+        alignas(64) std::atomic<size_t> head;
+        alignas(64) std::atomic<size_t> tail;
+        alignas(64) std::array<T, Capacity> items;
+    };
+}
\ No newline at end of file
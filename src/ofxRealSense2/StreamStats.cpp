@@ -0,0 +1,27 @@
+#include "StreamStats.h"
+
+namespace ofxRealSense2
+{
+    StreamStats::StreamStats()
+    {
+        this->clear();
+    }
+
+    void StreamStats::addFrame(double timestamp)
+    {
+        if (this->numFrames > 0 && timestamp > this->lastTimestamp)
+        {
+            const float frameRate = (float)(1000.0 / (timestamp - this->lastTimestamp));
+            this->frameRate = (this->frameRate > 0.0f) ? (this->frameRate * 0.9f + frameRate * 0.1f) : frameRate;
+        }
+        this->lastTimestamp = timestamp;
+        ++this->numFrames;
+    }
+
+    void StreamStats::clear()
+    {
+        this->numFrames = 0;
+        this->frameRate = 0.0f;
+        this->lastTimestamp = 0.0;
+    }
+}
\ No newline at end of file
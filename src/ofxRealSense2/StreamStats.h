@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ofxRealSense2
+{
+    // Frame count and rate of a stream, measured from the frame timestamps.
+    struct StreamStats
+    {
+        StreamStats();
+
+        void addFrame(double timestamp);
+        void clear();
+
+        uint64_t numFrames;
+        // Frames per second, smoothed over the last few frames.
+        float frameRate;
+        // Milliseconds.
+        double lastTimestamp;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace ofxRealSense2
+{
+    ThreadPool & ThreadPool::getShared()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    ThreadPool::ThreadPool(int numThreads)
+        : jobFunc(nullptr)
+        , jobData(nullptr)
+        , jobCount(0)
+        , nextIdx(0)
+        , pending(0)
+        , activeWorkers(0)
+        , generation(0)
+        , stopping(false)
+    {
+        if (numThreads <= 0)
+        {
+            // Leave a core for the calling thread.
+            numThreads = std::max(1, (int)std::thread::hardware_concurrency()) - 1;
+        }
+
+        for (int i = 0; i < numThreads; ++i)
+        {
+            this->threads.emplace_back(&ThreadPool::threadLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->wakeCondition.notify_all();
+
+        for (auto & thread : this->threads)
+        {
+            thread.join();
+        }
+    }
+
+    int ThreadPool::getConcurrency() const
+    {
+        return (int)this->threads.size() + 1;
+    }
+
+    void ThreadPool::run(int count, JobFunc func, void * data)
+    {
+        std::unique_lock<std::mutex> jobLock(this->jobMutex, std::try_to_lock);
+        if (!jobLock.owns_lock() || this->threads.empty() || count < 2)
+        {
+            // Busy or not worth it, run inline.
+            for (int i = 0; i < count; ++i)
+            {
+                func(data, i);
+            }
+            return;
+        }
+
+        {
+            // Workers still leaving the previous job must not pick up this one half set up.
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->doneCondition.wait(lock, [this]
+            {
+                return this->activeWorkers == 0;
+            });
+
+            this->jobFunc = func;
+            this->jobData = data;
+            this->jobCount = count;
+            this->pending = count;
+            // Publishing the index last makes the job visible to late workers.
+            this->nextIdx = 0;
+            ++this->generation;
+        }
+        this->wakeCondition.notify_all();
+
+        this->work();
+
+        // Wait for stragglers too, the job data lives on the caller's stack.
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->doneCondition.wait(lock, [this]
+        {
+            return this->pending == 0 && this->activeWorkers == 0;
+        });
+    }
+
+    void ThreadPool::work()
+    {
+        while (true)
+        {
+            const int idx = this->nextIdx.fetch_add(1);
+            if (idx >= this->jobCount) break;
+
+            this->jobFunc(this->jobData, idx);
+            --this->pending;
+        }
+    }
+
+    void ThreadPool::threadLoop()
+    {
+        unsigned int seenGeneration = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->wakeCondition.wait(lock, [&]
+                {
+                    return this->stopping || this->generation != seenGeneration;
+                });
+                if (this->stopping) return;
+
+                seenGeneration = this->generation;
+                ++this->activeWorkers;
+            }
+
+            this->work();
+
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                --this->activeWorkers;
+            }
+            this->doneCondition.notify_all();
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ofxRealSense2
+{
+    // Fixed set of helper threads for splitting per-frame work into chunks.
+    // The calling thread works on the job too. If the pool is already busy with
+    // another caller's job, the loop just runs inline on the calling thread, so
+    // several device threads can share one pool without waiting on each other.
+    class ThreadPool
+    {
+    public:
+        // Pool shared by all devices, sized to the hardware.
+        static ThreadPool & getShared();
+
+        ThreadPool(int numThreads = 0);
+        ~ThreadPool();
+
+        // Calls func(idx) for every idx in [0, count), returns when all calls are done.
+        template<typename Func>
+        void parallelFor(int count, Func && func)
+        {
+            this->run(count, &ThreadPool::invoke<typename std::remove_reference<Func>::type>, &func);
+        }
+
+        // Number of chunks worth splitting a job into.
+        int getConcurrency() const;
+
+    private:
+        typedef void(*JobFunc)(void *, int);
+
+        template<typename Func>
+        static void invoke(void * data, int idx)
+        {
+            (*static_cast<Func *>(data))(idx);
+        }
+
+        void run(int count, JobFunc func, void * data);
+        void work();
+        void threadLoop();
+
+    private:
+        std::vector<std::thread> threads;
+
+        std::mutex jobMutex;
+        std::mutex mutex;
+        std::condition_variable wakeCondition;
+        std::condition_variable doneCondition;
+
+        JobFunc jobFunc;
+        void * jobData;
+        int jobCount;
+        std::atomic<int> nextIdx;
+        std::atomic<int> pending;
+        int activeWorkers;
+        unsigned int generation;
+        bool stopping;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+
+namespace ofxRealSense2
+{
+    // Hands data from a producer thread to a consumer thread without copying.
+    // The producer fills the back slot and publishes it, the consumer swaps in
+    // the latest published slot. Older unconsumed data is overwritten, and the
+    // slot storage is recycled so buffers keep their capacity between frames.
+    template<typename T>
+    class TripleBuffer
+    {
+    public:
+        TripleBuffer()
+            : backIdx(0)
+            , middleIdx(1)
+            , frontIdx(2)
+            , fresh(false)
+        {}
+
+        // Producer side.
+        T & getBack()
+        {
+            return this->slots[this->backIdx];
+        }
+
+        void publish()
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            std::swap(this->backIdx, this->middleIdx);
+            this->fresh = true;
+        }
+
+        // Consumer side, returns true if the front slot now holds new data.
+        bool consume()
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (!this->fresh) return false;
+
+            std::swap(this->frontIdx, this->middleIdx);
+            this->fresh = false;
+            return true;
+        }
+
+        T & getFront()
+        {
+            return this->slots[this->frontIdx];
+        }
+
+        const T & getFront() const
+        {
+            return this->slots[this->frontIdx];
+        }
+
+    private:
+        std::array<T, 3> slots;
+        int backIdx;
+        int middleIdx;
+        int frontIdx;
+        bool fresh;
+        std::mutex mutex;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,396 @@
+#include "TsdfVolume.h"
+
+#include "MarchingCubes.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ofxRealSense2
+{
+    namespace
+    {
+        const int BlockVoxels = TsdfVolume::BlockSize * TsdfVolume::BlockSize * TsdfVolume::BlockSize;
+
+        // Voxels of a block plus one voxel around it on the low sides and two on
+        // the high sides, enough for the cells and gradients of the block.
+        const int GridSize = TsdfVolume::BlockSize + 3;
+
+        inline int getGridIndex(int x, int y, int z)
+        {
+            return ((z + 1) * GridSize + (y + 1)) * GridSize + (x + 1);
+        }
+
+        inline int floorDiv(int value, int divisor)
+        {
+            return (value >= 0) ? value / divisor : -((-value + divisor - 1) / divisor);
+        }
+    }
+
+    TsdfVolume::TsdfVolume()
+        : voxelSize(0.01f)
+        , truncation(0.04f)
+        , maxWeight(64.0f)
+        , numBlocks(0)
+        , frameCount(0)
+        , meshCount(0)
+    {
+        this->mesh.setMode(OF_PRIMITIVE_TRIANGLES);
+    }
+
+    void TsdfVolume::setup(float voxelSize, float truncation, float maxWeight)
+    {
+        this->voxelSize = std::max(voxelSize, 0.0001f);
+        this->truncation = std::max(truncation, this->voxelSize);
+        this->maxWeight = std::max(maxWeight, 1.0f);
+        this->clear();
+    }
+
+    void TsdfVolume::clear()
+    {
+        this->numBlocks = 0;
+        this->blocks.clear();
+        this->mesh.getVertices().clear();
+        this->mesh.getNormals().clear();
+    }
+
+    void TsdfVolume::integrate(const uint16_t * depthData, const Intrinsics & intrinsics, float depthScale, const glm::mat4 & pose)
+    {
+        if (!intrinsics.isValid()) return;
+
+        ++this->frameCount;
+
+        const int width = intrinsics.getWidth();
+        const int height = intrinsics.getHeight();
+        const glm::vec3 origin(pose[3]);
+        const float blockExtent = this->voxelSize * BlockSize;
+        const float invBlockExtent = 1.0f / blockExtent;
+
+        // Collect the blocks the truncation band of each depth sample passes through.
+        // Every other pixel is enough, neighbouring samples mostly share blocks.
+        auto & pool = ThreadPool::getShared();
+        const int numStrips = std::max(1, std::min(pool.getConcurrency(), height / 32));
+        this->stripKeys.resize(numStrips);
+        pool.parallelFor(numStrips, [&](int s)
+        {
+            auto & keys = this->stripKeys[s];
+            keys.clear();
+
+            const int numSteps = (int)std::ceil(4.0f * this->truncation / blockExtent) + 1;
+            const int y0 = (height * s / numStrips + 1) & ~1;
+            const int y1 = height * (s + 1) / numStrips;
+            for (int y = y0; y < y1; y += 2)
+            {
+                const uint16_t * depthRow = depthData + size_t(y) * width;
+                for (int x = 0; x < width; x += 2)
+                {
+                    if (!depthRow[x]) continue;
+
+                    const glm::vec3 point = glm::vec3(pose * glm::vec4(intrinsics.deproject(glm::vec2(x, y), depthRow[x] * depthScale), 1.0f));
+                    const glm::vec3 direction = glm::normalize(point - origin);
+                    for (int i = 0; i < numSteps; ++i)
+                    {
+                        const float offset = -this->truncation + 2.0f * this->truncation * i / std::max(numSteps - 1, 1);
+                        const glm::vec3 sample = (point + direction * offset) * invBlockExtent;
+                        const uint64_t key = getKey(glm::ivec3((int)std::floor(sample.x), (int)std::floor(sample.y), (int)std::floor(sample.z)));
+                        if (keys.empty() || keys.back() != key)
+                        {
+                            keys.push_back(key);
+                        }
+                    }
+                }
+            }
+        });
+
+        // Allocation touches the hash map, so it stays on this thread.
+        this->integrateBlocks.clear();
+        for (const auto & keys : this->stripKeys)
+        {
+            for (auto key : keys)
+            {
+                Block * block;
+                auto it = this->blocks.find(key);
+                if (it != this->blocks.end())
+                {
+                    block = it->second;
+                }
+                else
+                {
+                    const glm::ivec3 coords(int((key >> 42) & 0x1FFFFF) - (1 << 20), int((key >> 21) & 0x1FFFFF) - (1 << 20), int(key & 0x1FFFFF) - (1 << 20));
+                    block = this->allocateBlock(coords);
+                }
+
+                if (block->integrateStamp != this->frameCount)
+                {
+                    block->integrateStamp = this->frameCount;
+                    this->integrateBlocks.push_back(block);
+                }
+            }
+        }
+
+        // Blocks don't share voxels, so they integrate independently.
+        pool.parallelFor((int)this->integrateBlocks.size(), [&](int idx)
+        {
+            this->integrateBlock(*this->integrateBlocks[idx], depthData, intrinsics, depthScale, pose);
+        });
+    }
+
+    size_t TsdfVolume::updateMesh()
+    {
+        ++this->meshCount;
+
+        // A block's cells reach into its neighbours on the high sides, and the normal
+        // gradients read one voxel into the low sides, so changes re-mesh all 26 neighbours.
+        this->meshBlocks.clear();
+        for (size_t i = 0; i < this->numBlocks; ++i)
+        {
+            auto & block = this->arena[i / ChunkSize][i % ChunkSize];
+            if (!block.dirty) continue;
+
+            block.dirty = false;
+            for (int n = 0; n < 27; ++n)
+            {
+                const glm::ivec3 offset(n % 3 - 1, (n / 3) % 3 - 1, n / 9 - 1);
+                Block * neighbour = (n == 13) ? &block : this->findBlock(block.coords + offset);
+                if (neighbour && neighbour->meshStamp != this->meshCount)
+                {
+                    neighbour->meshStamp = this->meshCount;
+                    this->meshBlocks.push_back(neighbour);
+                }
+            }
+        }
+        if (this->meshBlocks.empty()) return 0;
+
+        ThreadPool::getShared().parallelFor((int)this->meshBlocks.size(), [&](int idx)
+        {
+            this->meshBlock(*this->meshBlocks[idx]);
+        });
+
+        // Gather the block meshes, the buffers are only reallocated on growth.
+        size_t numVertices = 0;
+        for (size_t i = 0; i < this->numBlocks; ++i)
+        {
+            numVertices += this->arena[i / ChunkSize][i % ChunkSize].vertices.size();
+        }
+
+        auto & vertices = this->mesh.getVertices();
+        auto & normals = this->mesh.getNormals();
+        vertices.resize(numVertices);
+        normals.resize(numVertices);
+        size_t offset = 0;
+        for (size_t i = 0; i < this->numBlocks; ++i)
+        {
+            const auto & block = this->arena[i / ChunkSize][i % ChunkSize];
+            std::copy(block.vertices.begin(), block.vertices.end(), vertices.begin() + offset);
+            std::copy(block.normals.begin(), block.normals.end(), normals.begin() + offset);
+            offset += block.vertices.size();
+        }
+
+        return this->meshBlocks.size();
+    }
+
+    const ofMesh & TsdfVolume::getMesh() const
+    {
+        return this->mesh;
+    }
+
+    size_t TsdfVolume::getNumBlocks() const
+    {
+        return this->numBlocks;
+    }
+
+    float TsdfVolume::getVoxelSize() const
+    {
+        return this->voxelSize;
+    }
+
+    float TsdfVolume::getTruncation() const
+    {
+        return this->truncation;
+    }
+
+    uint64_t TsdfVolume::getKey(const glm::ivec3 & coords)
+    {
+        // 21 bits per axis, offset to keep them positive.
+        return (uint64_t((coords.x + (1 << 20)) & 0x1FFFFF) << 42) |
+            (uint64_t((coords.y + (1 << 20)) & 0x1FFFFF) << 21) |
+            uint64_t((coords.z + (1 << 20)) & 0x1FFFFF);
+    }
+
+    TsdfVolume::Block * TsdfVolume::findBlock(const glm::ivec3 & coords) const
+    {
+        auto it = this->blocks.find(getKey(coords));
+        return (it != this->blocks.end()) ? it->second : nullptr;
+    }
+
+    TsdfVolume::Block * TsdfVolume::allocateBlock(const glm::ivec3 & coords)
+    {
+        if (this->numBlocks == this->arena.size() * ChunkSize)
+        {
+            this->arena.emplace_back(new Block[ChunkSize]);
+        }
+
+        auto & block = this->arena[this->numBlocks / ChunkSize][this->numBlocks % ChunkSize];
+        ++this->numBlocks;
+
+        block.coords = coords;
+        std::fill(block.voxels, block.voxels + BlockVoxels, Voxel{ 1.0f, 0.0f });
+        block.dirty = false;
+        block.integrateStamp = 0;
+        block.meshStamp = 0;
+        block.vertices.clear();
+        block.normals.clear();
+
+        this->blocks[getKey(coords)] = &block;
+        return &block;
+    }
+
+    void TsdfVolume::integrateBlock(Block & block, const uint16_t * depthData, const Intrinsics & intrinsics, float depthScale, const glm::mat4 & pose) const
+    {
+        // Camera space position of the first voxel and the steps along each volume axis.
+        // The rotation is orthonormal, so its transpose is the inverse.
+        const glm::vec3 axisX(pose[0]);
+        const glm::vec3 axisY(pose[1]);
+        const glm::vec3 axisZ(pose[2]);
+        const glm::vec3 origin(pose[3]);
+        const glm::vec3 first = glm::vec3(block.coords.x, block.coords.y, block.coords.z) * (this->voxelSize * BlockSize) - origin;
+        const glm::vec3 base(glm::dot(axisX, first), glm::dot(axisY, first), glm::dot(axisZ, first));
+        const glm::vec3 stepX = glm::vec3(axisX.x, axisY.x, axisZ.x) * this->voxelSize;
+        const glm::vec3 stepY = glm::vec3(axisX.y, axisY.y, axisZ.y) * this->voxelSize;
+        const glm::vec3 stepZ = glm::vec3(axisX.z, axisY.z, axisZ.z) * this->voxelSize;
+
+        const int width = intrinsics.getWidth();
+        const int height = intrinsics.getHeight();
+        const auto & native = intrinsics.getNative();
+        const bool pinhole = intrinsics.isPinhole();
+        const float invTruncation = 1.0f / this->truncation;
+
+        bool changed = false;
+        Voxel * voxel = block.voxels;
+        for (int z = 0; z < BlockSize; ++z)
+        {
+            for (int y = 0; y < BlockSize; ++y)
+            {
+                glm::vec3 point = base + stepZ * (float)z + stepY * (float)y;
+                for (int x = 0; x < BlockSize; ++x, ++voxel, point += stepX)
+                {
+                    if (point.z <= 0.0f) continue;
+
+                    glm::vec2 pixel;
+                    if (pinhole)
+                    {
+                        pixel = glm::vec2(point.x / point.z * native.fx + native.ppx, point.y / point.z * native.fy + native.ppy);
+                    }
+                    else
+                    {
+                        pixel = intrinsics.project(point);
+                    }
+
+                    const int u = (int)std::floor(pixel.x + 0.5f);
+                    const int v = (int)std::floor(pixel.y + 0.5f);
+                    if (u < 0 || v < 0 || u >= width || v >= height) continue;
+
+                    const uint16_t rawDepth = depthData[size_t(v) * width + u];
+                    if (!rawDepth) continue;
+
+                    // Projective distance along the view axis, skipped well behind the surface.
+                    const float distance = rawDepth * depthScale - point.z;
+                    if (distance < -this->truncation) continue;
+
+                    const float tsdf = std::min(distance * invTruncation, 1.0f);
+                    voxel->tsdf = (voxel->tsdf * voxel->weight + tsdf) / (voxel->weight + 1.0f);
+                    voxel->weight = std::min(voxel->weight + 1.0f, this->maxWeight);
+                    changed = true;
+                }
+            }
+        }
+
+        if (changed)
+        {
+            block.dirty = true;
+        }
+    }
+
+    void TsdfVolume::meshBlock(Block & block) const
+    {
+        // Copy the block and the bordering voxels of its neighbours into one grid.
+        Voxel grid[GridSize * GridSize * GridSize];
+        for (int n = 0; n < 27; ++n)
+        {
+            const glm::ivec3 offset(n % 3 - 1, (n / 3) % 3 - 1, n / 9 - 1);
+            const int x0 = std::max(offset.x * BlockSize, -1);
+            const int y0 = std::max(offset.y * BlockSize, -1);
+            const int z0 = std::max(offset.z * BlockSize, -1);
+            const int x1 = std::min(offset.x * BlockSize + BlockSize, BlockSize + 2);
+            const int y1 = std::min(offset.y * BlockSize + BlockSize, BlockSize + 2);
+            const int z1 = std::min(offset.z * BlockSize + BlockSize, BlockSize + 2);
+
+            const Block * source = (n == 13) ? &block : this->findBlock(block.coords + offset);
+            for (int z = z0; z < z1; ++z)
+            {
+                for (int y = y0; y < y1; ++y)
+                {
+                    for (int x = x0; x < x1; ++x)
+                    {
+                        const int idx = ((z - offset.z * BlockSize) * BlockSize + (y - offset.y * BlockSize)) * BlockSize + (x - offset.x * BlockSize);
+                        grid[getGridIndex(x, y, z)] = source ? source->voxels[idx] : Voxel{ 1.0f, 0.0f };
+                    }
+                }
+            }
+        }
+
+        auto gradient = [&grid](int x, int y, int z)
+        {
+            return glm::vec3(grid[getGridIndex(x + 1, y, z)].tsdf - grid[getGridIndex(x - 1, y, z)].tsdf,
+                             grid[getGridIndex(x, y + 1, z)].tsdf - grid[getGridIndex(x, y - 1, z)].tsdf,
+                             grid[getGridIndex(x, y, z + 1)].tsdf - grid[getGridIndex(x, y, z - 1)].tsdf);
+        };
+
+        block.vertices.clear();
+        block.normals.clear();
+
+        const glm::vec3 blockOrigin = glm::vec3(block.coords.x, block.coords.y, block.coords.z) * (float)BlockSize;
+        for (int z = 0; z < BlockSize; ++z)
+        {
+            for (int y = 0; y < BlockSize; ++y)
+            {
+                for (int x = 0; x < BlockSize; ++x)
+                {
+                    // Only cells where every corner has been observed.
+                    float values[8];
+                    int cubeIndex = 0;
+                    bool observed = true;
+                    for (int c = 0; c < 8 && observed; ++c)
+                    {
+                        const auto & voxel = grid[getGridIndex(x + (c & 1), y + ((c >> 1) & 1), z + ((c >> 2) & 1))];
+                        observed = voxel.weight > 0.0f;
+                        values[c] = voxel.tsdf;
+                        if (voxel.tsdf < 0.0f)
+                        {
+                            cubeIndex |= 1 << c;
+                        }
+                    }
+                    if (!observed || cubeIndex == 0 || cubeIndex == 0xFF) continue;
+
+                    for (const int8_t * edge = MarchingCubes::getTriangles(cubeIndex); *edge >= 0; ++edge)
+                    {
+                        const int c0 = MarchingCubes::getEdgeCorner(*edge, 0);
+                        const int c1 = MarchingCubes::getEdgeCorner(*edge, 1);
+                        const glm::ivec3 p0(x + (c0 & 1), y + ((c0 >> 1) & 1), z + ((c0 >> 2) & 1));
+                        const glm::ivec3 p1(x + (c1 & 1), y + ((c1 >> 1) & 1), z + ((c1 >> 2) & 1));
+                        const float t = values[c0] / (values[c0] - values[c1]);
+
+                        const glm::vec3 position = glm::vec3(p0.x, p0.y, p0.z) + glm::vec3(p1.x - p0.x, p1.y - p0.y, p1.z - p0.z) * t;
+                        block.vertices.push_back((blockOrigin + position) * this->voxelSize);
+
+                        const glm::vec3 g0 = gradient(p0.x, p0.y, p0.z);
+                        const glm::vec3 g1 = gradient(p1.x, p1.y, p1.z);
+                        const glm::vec3 normal = g0 + (g1 - g0) * t;
+                        const float length = glm::length(normal);
+                        block.normals.push_back((length > 0.0f) ? normal / length : glm::vec3(0.0f));
+                    }
+                }
+            }
+        }
+    }
+}
\ No newline at end of file
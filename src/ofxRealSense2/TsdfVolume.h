@@ -0,0 +1,92 @@
+#pragma once
+
+#include "ofMesh.h"
+#include "ofVectorMath.h"
+
+#include "Intrinsics.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace ofxRealSense2
+{
+    // Truncated signed distance volume for fusing depth frames into a surface,
+    // KinectFusion style, on the CPU. Space is split into blocks of voxels that
+    // are only allocated near observed surfaces, looked up through a hash map
+    // and carved out of a block arena. Distances are positive in front of the
+    // surface and normalized by the truncation distance.
+    class TsdfVolume
+    {
+    public:
+        static const int BlockSize = 8;
+
+        struct Voxel
+        {
+            float tsdf;
+            float weight;
+        };
+
+        TsdfVolume();
+
+        // Clears the volume. Sizes are in meters, the weight caps the running
+        // average so the volume can still adapt to changes.
+        void setup(float voxelSize = 0.01f, float truncation = 0.04f, float maxWeight = 64.0f);
+        void clear();
+
+        // Fuses a depth frame. The pose maps depth camera space to volume space, it must be rigid.
+        void integrate(const uint16_t * depthData, const Intrinsics & intrinsics, float depthScale, const glm::mat4 & pose);
+
+        // Runs marching cubes on the blocks changed since the last call and their
+        // neighbours, then rebuilds the mesh. Returns the number of blocks meshed.
+        size_t updateMesh();
+
+        // Triangles in volume space, with normals from the distance gradient.
+        const ofMesh & getMesh() const;
+
+        size_t getNumBlocks() const;
+        float getVoxelSize() const;
+        float getTruncation() const;
+
+    private:
+        struct Block
+        {
+            glm::ivec3 coords;
+            Voxel voxels[BlockSize * BlockSize * BlockSize];
+            bool dirty;
+            // Last frame and mesh pass the block was queued for, to skip duplicates.
+            uint64_t integrateStamp;
+            uint64_t meshStamp;
+            std::vector<glm::vec3> vertices;
+            std::vector<glm::vec3> normals;
+        };
+
+        static uint64_t getKey(const glm::ivec3 & coords);
+
+        Block * findBlock(const glm::ivec3 & coords) const;
+        Block * allocateBlock(const glm::ivec3 & coords);
+
+        void integrateBlock(Block & block, const uint16_t * depthData, const Intrinsics & intrinsics, float depthScale, const glm::mat4 & pose) const;
+        void meshBlock(Block & block) const;
+
+    private:
+        float voxelSize;
+        float truncation;
+        float maxWeight;
+
+        // Blocks are allocated in chunks that are kept across clears.
+        static const size_t ChunkSize = 256;
+        std::vector<std::unique_ptr<Block[]>> arena;
+        size_t numBlocks;
+        std::unordered_map<uint64_t, Block *> blocks;
+
+        uint64_t frameCount;
+        uint64_t meshCount;
+        std::vector<std::vector<uint64_t>> stripKeys;
+        std::vector<Block *> integrateBlocks;
+        std::vector<Block *> meshBlocks;
+
+        ofMesh mesh;
+    };
+}
\ No newline at end of file
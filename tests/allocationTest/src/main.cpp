@@ -0,0 +1,401 @@
+#include "ofMain.h"
+#include "ofxRealSense2.h"
+#include "ofxRealSense2/ColorConverter.h"
+#include "ofxRealSense2/DepthConverter.h"
+#include "ofxRealSense2/DepthMesh.h"
+#include "ofxRealSense2/DepthPyramid.h"
+#include "ofxRealSense2/NormalEstimator.h"
+#include "ofxRealSense2/OptionQueue.h"
+#include "ofxRealSense2/StreamStats.h"
+#include "ofxRealSense2/TripleBuffer.h"
+
+#include "../../common/TestDevice.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <random>
+
+// Counts global operator new calls in two parts, both failing on any allocation
+// after a few warm-up frames.
+//
+// First, synthetic depth and color frames go through every per-frame stage of
+// the device thread, and the lazy depth coloring of the main thread. The frames
+// vary in holes, blob count and depth range so buffers sized by content would
+// show up.
+//
+// Then a Device runs on the recording or camera from TestDevice.h with every
+// output enabled, and the main thread is checked around update() and the
+// getters. librealsense allocates its own frames on the device thread, so the
+// process wide count is only reported.
+namespace
+{
+    std::atomic<bool> counting(false);
+    std::atomic<int> numAllocations(0);
+    thread_local bool countingThread = false;
+    thread_local int numThreadAllocations = 0;
+}
+
+void * operator new(std::size_t size)
+{
+    if (counting)
+    {
+        ++numAllocations;
+    }
+    if (countingThread)
+    {
+        ++numThreadAllocations;
+    }
+    if (void * ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void * operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void * ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void * ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void * ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void * ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace
+{
+    const int Width = 848;
+    const int Height = 480;
+    const float DepthScale = 0.001f;
+    const int WarmUpFrames = 30;
+    const int CheckedFrames = 300;
+
+    struct Stage
+    {
+        std::string name;
+        std::function<void()> run;
+        int numAllocations;
+    };
+
+    // Floor with boxes in front of it, random holes and noise.
+    void makeDepth(std::mt19937 & random, int frame, std::vector<uint16_t> & depth)
+    {
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        const float holeRate = unit(random) * 0.3f;
+        const int numBoxes = random() % 24;
+
+        for (int y = 0; y < Height; ++y)
+        {
+            for (int x = 0; x < Width; ++x)
+            {
+                depth[y * Width + x] = uint16_t(1500 + y * 4 + (random() % 8));
+            }
+        }
+        for (int b = 0; b < numBoxes; ++b)
+        {
+            const int w = 8 + random() % 120;
+            const int h = 8 + random() % 120;
+            const int x0 = (random() + frame * 3) % (Width - w);
+            const int y0 = random() % (Height - h);
+            const uint16_t z = uint16_t(500 + random() % 1500);
+            for (int y = y0; y < y0 + h; ++y)
+            {
+                std::fill(depth.begin() + y * Width + x0, depth.begin() + y * Width + x0 + w, z);
+            }
+        }
+        for (auto & d : depth)
+        {
+            if (unit(random) < holeRate) d = 0;
+        }
+    }
+}
+
+// Returns the number of allocations after warm-up.
+int runStages()
+{
+    std::mt19937 random(1);
+
+    rs2_intrinsics nativeIntrinsics = {};
+    nativeIntrinsics.width = Width;
+    nativeIntrinsics.height = Height;
+    nativeIntrinsics.ppx = Width * 0.5f;
+    nativeIntrinsics.ppy = Height * 0.5f;
+    nativeIntrinsics.fx = 420.0f;
+    nativeIntrinsics.fy = 420.0f;
+    nativeIntrinsics.model = RS2_DISTORTION_BROWN_CONRADY;
+    const ofxRealSense2::Intrinsics intrinsics(nativeIntrinsics);
+
+    std::vector<uint16_t> depth(Width * Height);
+    std::vector<uint8_t> yuyv(Width * Height * 2);
+    std::vector<glm::vec3> vertices(Width * Height);
+
+    // Device thread state.
+    ofxRealSense2::BackgroundModel backgroundModel;
+    ofxRealSense2::BlobFinder blobFinder;
+    ofxRealSense2::OccupancyGrid occupancyGrid;
+    ofxRealSense2::DepthMesh depthMesh;
+    ofxRealSense2::StreamStats streamStats;
+    occupancyGrid.setup(128, 128, 0.05f);
+    // Ground space is camera space, so most points land in the grid.
+    occupancyGrid.setGroundPose(glm::mat4(1.0f));
+    occupancyGrid.setHeightRange(0.0f, 10.0f);
+
+    struct Slot
+    {
+        ofPixels foregroundPix;
+        ofPixels maskPix;
+        std::vector<ofxRealSense2::Blob> blobs;
+        ofxRealSense2::RegionStats regionStats;
+        ofFloatPixels floatDepthPix;
+        ofxRealSense2::DepthPyramid pyramid;
+        ofMesh mesh;
+        std::vector<glm::vec3> normals;
+        ofPixels colorPix;
+    };
+    ofxRealSense2::TripleBuffer<Slot> buffer;
+
+    // Main thread state.
+    ofPixels depthPix;
+    std::vector<uint32_t> depthHistogram(ofxRealSense2::DepthConverter::HistogramSize);
+    ofxRealSense2::OptionQueue optionQueue;
+
+    std::vector<Stage> stages =
+    {
+        { "Background model", [&]
+        {
+            auto & slot = buffer.getBack();
+            if (slot.foregroundPix.getWidth() != Width) slot.foregroundPix.allocate(Width, Height, OF_IMAGE_GRAYSCALE);
+            backgroundModel.update(depth.data(), Width, Height, DepthScale, slot.foregroundPix.getData());
+        }},
+        { "Blobs", [&]
+        {
+            auto & slot = buffer.getBack();
+            if (slot.maskPix.getWidth() != Width) slot.maskPix.allocate(Width, Height, OF_IMAGE_GRAYSCALE);
+            ofxRealSense2::BlobFinder::threshold(depth.data(), depth.size(), 400, 2000, slot.maskPix.getData());
+            blobFinder.setMinArea(50);
+            blobFinder.setMaxBlobs(16);
+            blobFinder.find(slot.maskPix.getData(), depth.data(), Width, Height, DepthScale, slot.blobs);
+        }},
+        { "Region stats", [&]
+        {
+            buffer.getBack().regionStats.update(depth.data(), Width, Height, DepthScale, 16, 10.0f);
+        }},
+        { "Float depth", [&]
+        {
+            auto & slot = buffer.getBack();
+            if (slot.floatDepthPix.getWidth() != Width) slot.floatDepthPix.allocate(Width, Height, OF_IMAGE_GRAYSCALE);
+            ofxRealSense2::DepthConverter::toMeters(depth.data(), depth.size(), DepthScale, 0.0f, slot.floatDepthPix.getData());
+        }},
+        { "Pyramid", [&]
+        {
+            buffer.getBack().pyramid.update(depth.data(), Width, Height, 4, ofxRealSense2::DepthPyramid::Median);
+        }},
+        { "Mesh", [&]
+        {
+            depthMesh.update(depth.data(), intrinsics, DepthScale, 2, 0.05f, buffer.getBack().mesh);
+        }},
+        { "Occupancy", [&]
+        {
+            occupancyGrid.update(depth.data(), intrinsics, DepthScale);
+        }},
+        { "Normals", [&]
+        {
+            auto & normals = buffer.getBack().normals;
+            normals.resize(vertices.size());
+            ofxRealSense2::NormalEstimator::estimate(vertices.data(), Width, Height, 2, normals.data());
+        }},
+        { "Color conversion", [&]
+        {
+            auto & slot = buffer.getBack();
+            if (slot.colorPix.getWidth() != Width) slot.colorPix.allocate(Width, Height, OF_IMAGE_COLOR);
+            ofxRealSense2::ColorConverter::convert(yuyv.data(), Width, Height, Width * 2, RS2_FORMAT_YUYV, slot.colorPix.getData(), OF_PIXELS_RGB);
+        }},
+        { "Stream stats", [&]
+        {
+            streamStats.addFrame(ofGetElapsedTimeMillis());
+        }},
+        { "Publish", [&]
+        {
+            buffer.publish();
+            buffer.consume();
+        }},
+        { "Depth coloring", [&]
+        {
+            if (depthPix.getWidth() != Width) depthPix.allocate(Width, Height, OF_IMAGE_COLOR);
+            ofxRealSense2::DepthConverter::toGray(depth.data(), depth.size(), DepthScale, 0.3f, 4.0f, depthPix.getData());
+            ofxRealSense2::DepthConverter::toGrayEqualized(depth.data(), depth.size(), depthHistogram.data(), depthPix.getData());
+        }},
+        { "Option posts", [&]
+        {
+            optionQueue.post(RS2_OPTION_EXPOSURE, float(random() % 1000));
+            optionQueue.post(RS2_OPTION_GAIN, float(random() % 100));
+        }}
+    };
+
+    for (int frame = 0; frame < WarmUpFrames + CheckedFrames; ++frame)
+    {
+        makeDepth(random, frame, depth);
+        for (auto & byte : yuyv)
+        {
+            byte = uint8_t(random());
+        }
+        for (int i = 0; i < Width * Height; ++i)
+        {
+            vertices[i] = intrinsics.deproject(glm::vec2(i % Width, i / Width), depth[i] * DepthScale);
+        }
+
+        for (auto & stage : stages)
+        {
+            numAllocations = 0;
+            counting = frame >= WarmUpFrames;
+            stage.run();
+            counting = false;
+            stage.numAllocations += numAllocations;
+        }
+    }
+
+    int totalAllocations = 0;
+    for (const auto & stage : stages)
+    {
+        ofLogNotice("allocationTest") << stage.name << ": " << stage.numAllocations << " allocations";
+        totalAllocations += stage.numAllocations;
+    }
+
+    return totalAllocations;
+}
+
+class ofApp
+    : public ofBaseApp
+{
+public:
+    void setup() override
+    {
+        ofSetVerticalSync(false);
+        ofSetFrameRate(0);
+
+        // The device isn't open yet, so only the stages and the pool allocate here.
+        this->stageAllocations = runStages();
+
+        auto nativeDevice = openTestDevice(this->context);
+        this->device = std::make_unique<ofxRealSense2::Device>(this->context, nativeDevice);
+        enableTestDepth(*this->device, nativeDevice);
+        this->device->enablePoints();
+        this->device->getOccupancyGrid().setup(128, 128, 0.05f);
+        this->device->startPipeline();
+
+        // The parameters are set up by the start.
+        this->device->backgroundEnabled = true;
+        this->device->blobsEnabled = true;
+        this->device->regionStatsEnabled = true;
+        this->device->floatDepthEnabled = true;
+        this->device->pyramidEnabled = true;
+        this->device->meshEnabled = true;
+        this->device->pointNormalsEnabled = true;
+        this->device->occupancyEnabled = true;
+
+        this->lastFrameNumber = 0;
+        this->numFrames = 0;
+        this->deviceAllocations = 0;
+        this->processAllocations = 0;
+    }
+
+    void update() override
+    {
+        const bool checked = this->numFrames >= WarmUpFrames;
+        numThreadAllocations = 0;
+        countingThread = checked;
+
+        this->device->update();
+        const auto frameNumber = this->device->getDepthMetadata().frameNumber;
+        const bool newFrame = frameNumber != this->lastFrameNumber;
+        if (newFrame)
+        {
+            this->lastFrameNumber = frameNumber;
+            this->device->getDepthPix();
+            this->device->getRawDepthPix();
+            this->device->getFloatDepthPix();
+            this->device->getForegroundPix();
+            this->device->getDepthTex();
+            this->device->getRawDepthTex();
+            this->device->getFloatDepthTex();
+            this->device->getForegroundTex();
+            this->device->getBlobs();
+            this->device->getRegionStats();
+            this->device->getDepthPyramid();
+            this->device->getPointsMesh();
+            this->device->getSurfaceMesh();
+            this->device->getDepthStats();
+        }
+
+        countingThread = false;
+        this->deviceAllocations += numThreadAllocations;
+        if (!newFrame) return;
+
+        ++this->numFrames;
+        if (this->numFrames == WarmUpFrames)
+        {
+            numAllocations = 0;
+            counting = true;
+        }
+        else if (this->numFrames == WarmUpFrames + CheckedFrames)
+        {
+            counting = false;
+            this->processAllocations = numAllocations;
+            ofExit(this->report() ? 0 : 1);
+        }
+    }
+
+    void exit() override
+    {
+        this->device.reset();
+    }
+
+    bool report()
+    {
+        ofLogNotice("allocationTest") << "Device update and getters: " << this->deviceAllocations << " allocations";
+        ofLogNotice("allocationTest") << "Whole process with the device running: "
+            << ofToString(double(this->processAllocations) / CheckedFrames, 1) << " allocations per frame";
+
+        const int totalAllocations = this->stageAllocations + this->deviceAllocations;
+        if (totalAllocations > 0)
+        {
+            ofLogError("allocationTest") << "FAILED, " << totalAllocations << " allocations over " << CheckedFrames << " frames";
+            return false;
+        }
+        ofLogNotice("allocationTest") << "PASSED, no allocations over " << CheckedFrames << " frames";
+        return true;
+    }
+
+private:
+    rs2::context context;
+    std::unique_ptr<ofxRealSense2::Device> device;
+
+    unsigned long long lastFrameNumber;
+    int numFrames;
+    int stageAllocations;
+    int deviceAllocations;
+    int processAllocations;
+};
+
+int main()
+{
+    ofSetupOpenGL(640, 360, OF_WINDOW);
+    return ofRunApp(new ofApp());
+}
\ No newline at end of file
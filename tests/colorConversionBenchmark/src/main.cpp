@@ -0,0 +1,136 @@
+#include "ofMain.h"
+#include "ofxRealSense2/ColorConverter.h"
+
+#include "librealsense2/hpp/rs_internal.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <random>
+
+// Compares ColorConverter with librealsense's own YUYV to RGB8 conversion, the
+// yuy_decoder block, on the same frames. The frames come from a software
+// device, so it needs no camera. ColorConverter is timed on one thread and on
+// the shared pool, the decoder runs on one thread. Also reports the largest
+// channel difference between the two outputs.
+namespace
+{
+    const int NumIterations = 200;
+
+    struct Resolution
+    {
+        int width;
+        int height;
+    };
+
+    template<typename Func>
+    double timeMs(Func && func)
+    {
+        const auto startTime = std::chrono::steady_clock::now();
+        for (int i = 0; i < NumIterations; ++i)
+        {
+            func();
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count() / NumIterations;
+    }
+}
+
+int main()
+{
+    const Resolution resolutions[] = { { 640, 480 }, { 848, 480 }, { 1280, 720 }, { 1920, 1080 } };
+
+    rs2::software_device softwareDevice;
+    auto sensor = softwareDevice.add_sensor("RGB Camera");
+    std::vector<rs2::stream_profile> profiles;
+    for (const auto & resolution : resolutions)
+    {
+        rs2_video_stream stream = {};
+        stream.type = RS2_STREAM_COLOR;
+        stream.uid = (int)profiles.size();
+        stream.width = resolution.width;
+        stream.height = resolution.height;
+        stream.fps = 30;
+        stream.bpp = 2;
+        stream.fmt = RS2_FORMAT_YUYV;
+        stream.intrinsics.width = resolution.width;
+        stream.intrinsics.height = resolution.height;
+        profiles.push_back(sensor.add_video_stream(stream));
+    }
+
+    int exitCode = 0;
+    std::mt19937 random(1);
+    for (size_t r = 0; r < profiles.size(); ++r)
+    {
+        const int width = resolutions[r].width;
+        const int height = resolutions[r].height;
+
+        // Random YUYV covers every luma and chroma combination the clamping has to handle.
+        auto yuyv = new uint8_t[size_t(width) * height * 2];
+        for (size_t i = 0; i < size_t(width) * height * 2; ++i)
+        {
+            yuyv[i] = uint8_t(random());
+        }
+
+        rs2::frame_queue queue(1);
+        sensor.open(profiles[r]);
+        sensor.start(queue);
+
+        rs2_software_video_frame videoFrame;
+        videoFrame.pixels = yuyv;
+        videoFrame.deleter = [](void * ptr)
+        {
+            delete[] static_cast<uint8_t *>(ptr);
+        };
+        videoFrame.stride = width * 2;
+        videoFrame.bpp = 2;
+        videoFrame.timestamp = 0.0;
+        videoFrame.domain = RS2_TIMESTAMP_DOMAIN_HARDWARE_CLOCK;
+        videoFrame.frame_number = 0;
+        videoFrame.profile = profiles[r].get();
+        sensor.on_video_frame(videoFrame);
+        const auto frame = queue.wait_for_frame();
+
+        sensor.stop();
+        sensor.close();
+
+        const auto srcData = (const uint8_t *)frame.get_data();
+        ofPixels pixels;
+        pixels.allocate(width, height, OF_IMAGE_COLOR);
+
+        rs2::yuy_decoder decoder;
+        rs2::video_frame decoded = decoder.process(frame);
+        const double decoderMs = timeMs([&]
+        {
+            decoded = decoder.process(frame);
+        });
+        const double singleMs = timeMs([&]
+        {
+            ofxRealSense2::ColorConverter::convert(srcData, size_t(width) * height, RS2_FORMAT_YUYV, pixels.getData(), OF_PIXELS_RGB);
+        });
+        const double poolMs = timeMs([&]
+        {
+            ofxRealSense2::ColorConverter::convert(srcData, width, height, width * 2, RS2_FORMAT_YUYV, pixels.getData(), OF_PIXELS_RGB);
+        });
+
+        int maxDifference = 0;
+        const auto decodedData = (const uint8_t *)decoded.get_data();
+        for (int y = 0; y < height; ++y)
+        {
+            const uint8_t * decodedRow = decodedData + y * decoded.get_stride_in_bytes();
+            const uint8_t * convertedRow = pixels.getData() + y * width * 3;
+            for (int x = 0; x < width * 3; ++x)
+            {
+                maxDifference = std::max(maxDifference, std::abs(decodedRow[x] - convertedRow[x]));
+            }
+        }
+
+        ofLogNotice("colorConversionBenchmark") << width << "x" << height << ": librealsense "
+            << ofToString(decoderMs, 3) << " ms, ColorConverter " << ofToString(singleMs, 3) << " ms on one thread, "
+            << ofToString(poolMs, 3) << " ms on the pool, max difference " << maxDifference;
+        if (maxDifference > 1)
+        {
+            exitCode = 1;
+        }
+    }
+
+    return exitCode;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxRealSense2.h"
+
+#include <stdexcept>
+
+// Tests and benchmarks run on the recording at data/recording.bag when there is
+// one, so runs are repeatable, otherwise on the first connected camera.
+inline rs2::device openTestDevice(rs2::context & context)
+{
+    const auto path = ofToDataPath("recording.bag", true);
+    if (ofFile::doesFileExist(path))
+    {
+        // Not real time, so frames come as fast as the device thread reads them.
+        auto playback = context.load_device(path);
+        playback.set_real_time(false);
+        return playback;
+    }
+
+    auto devices = context.query_devices();
+    if (devices.size() == 0)
+    {
+        throw std::runtime_error("No recording at " + path + " and no camera connected");
+    }
+    return devices[0];
+}
+
+// Enables depth with the recorded profile, or the default one on a camera.
+inline void enableTestDepth(ofxRealSense2::Device & device, const rs2::device & nativeDevice)
+{
+    if (nativeDevice.is<rs2::playback>())
+    {
+        for (auto & sensor : nativeDevice.query_sensors())
+        {
+            for (auto & profile : sensor.get_stream_profiles())
+            {
+                auto videoProfile = profile.as<rs2::video_stream_profile>();
+                if (videoProfile && videoProfile.stream_type() == RS2_STREAM_DEPTH)
+                {
+                    device.enableDepth(videoProfile.width(), videoProfile.height(), videoProfile.fps());
+                    return;
+                }
+            }
+        }
+    }
+    device.enableDepth();
+}
@@ -0,0 +1,148 @@
+#include "ofMain.h"
+#include "ofxRealSense2/Imu.h"
+#include "ofxRealSense2/SpscRing.h"
+
+#include "librealsense2/hpp/rs_internal.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Feeds a second of gyro (400 Hz) and accelerometer (250 Hz) frames through a
+// software device and checks what comes out the other end of the path the
+// device uses: ImuSample::fromFrame() on the sensor callback, the SPSC ring,
+// then the history on this thread. Values are linear in time, so reads and
+// interpolation can be checked exactly. Needs no camera.
+namespace
+{
+    const int GyroFps = 400;
+    const int AccelFps = 250;
+    const double Duration = 1000.0;
+
+    glm::vec3 gyroAt(double timestamp)
+    {
+        const float t = float(timestamp / 1000.0);
+        return glm::vec3(t, -t, 2.0f * t);
+    }
+
+    glm::vec3 accelAt(double timestamp)
+    {
+        return glm::vec3(0.0f, 9.81f, float(timestamp / 1000.0));
+    }
+
+    bool check(bool condition, const std::string & what)
+    {
+        if (!condition)
+        {
+            ofLogError("imuTest") << "FAILED: " << what;
+        }
+        return condition;
+    }
+}
+
+int main()
+{
+    rs2::software_device softwareDevice;
+    auto sensor = softwareDevice.add_sensor("Motion Module");
+
+    rs2_motion_device_intrinsic motionIntrinsics = {};
+    auto gyroProfile = sensor.add_motion_stream({ RS2_STREAM_GYRO, 0, 0, GyroFps, RS2_FORMAT_MOTION_XYZ32F, motionIntrinsics });
+    auto accelProfile = sensor.add_motion_stream({ RS2_STREAM_ACCEL, 0, 1, AccelFps, RS2_FORMAT_MOTION_XYZ32F, motionIntrinsics });
+
+    ofxRealSense2::SpscRing<ofxRealSense2::ImuSample, 2048> ring;
+    std::atomic<int> numReceived(0);
+    std::atomic<int> numDropped(0);
+    sensor.open({ gyroProfile, accelProfile });
+    sensor.start([&](rs2::frame frame)
+    {
+        ofxRealSense2::ImuSample sample;
+        if (ofxRealSense2::ImuSample::fromFrame(frame, sample))
+        {
+            if (!ring.push(sample))
+            {
+                ++numDropped;
+            }
+            ++numReceived;
+        }
+    });
+
+    // Interleave both streams in timestamp order, like the camera does.
+    const int numGyro = int(Duration * GyroFps / 1000.0);
+    const int numAccel = int(Duration * AccelFps / 1000.0);
+    int gyroIdx = 0;
+    int accelIdx = 0;
+    while (gyroIdx < numGyro || accelIdx < numAccel)
+    {
+        const double gyroTime = gyroIdx * 1000.0 / GyroFps;
+        const double accelTime = accelIdx * 1000.0 / AccelFps;
+        const bool gyro = gyroIdx < numGyro && (accelIdx >= numAccel || gyroTime <= accelTime);
+        const double timestamp = gyro ? gyroTime : accelTime;
+        const glm::vec3 value = gyro ? gyroAt(timestamp) : accelAt(timestamp);
+
+        float * data = new float[3] { value.x, value.y, value.z };
+        rs2_software_motion_frame motionFrame;
+        motionFrame.data = data;
+        motionFrame.deleter = [](void * ptr)
+        {
+            delete[] static_cast<float *>(ptr);
+        };
+        motionFrame.timestamp = timestamp;
+        motionFrame.domain = RS2_TIMESTAMP_DOMAIN_HARDWARE_CLOCK;
+        motionFrame.frame_number = gyro ? gyroIdx++ : accelIdx++;
+        motionFrame.profile = gyro ? gyroProfile.get() : accelProfile.get();
+        sensor.on_motion_frame(motionFrame);
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    while (numReceived < numGyro + numAccel && std::chrono::steady_clock::now() - startTime < std::chrono::seconds(2))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    sensor.stop();
+    sensor.close();
+
+    // Drained in batches, like Device::updateImu().
+    ofxRealSense2::ImuHistory history;
+    ofxRealSense2::ImuSample batch[64];
+    size_t numSamples;
+    while ((numSamples = ring.pop(batch, 64)) > 0)
+    {
+        history.add(batch, numSamples);
+    }
+
+    bool passed = true;
+    passed &= check(numReceived == numGyro + numAccel, "received " + ofToString(numReceived) + " of " + ofToString(numGyro + numAccel) + " frames");
+    passed &= check(numDropped == 0, ofToString(numDropped) + " samples dropped by the ring");
+    passed &= check(history.size() == size_t(numGyro + numAccel), "history holds " + ofToString(history.size()) + " samples");
+
+    // Everything after the halfway point, oldest first, with the values that went in.
+    std::vector<ofxRealSense2::ImuSample> samples;
+    const double since = Duration * 0.5;
+    history.read(since, samples);
+    const size_t numExpected = size_t(numGyro - (since * GyroFps / 1000.0 + 1)) + size_t(numAccel - (since * AccelFps / 1000.0 + 1));
+    passed &= check(samples.size() == numExpected, "read " + ofToString(samples.size()) + " samples since " + ofToString(since) + " ms, expected " + ofToString(numExpected));
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        const auto & sample = samples[i];
+        const auto expected = (sample.type == ofxRealSense2::ImuSample::Gyro) ? gyroAt(sample.timestamp) : accelAt(sample.timestamp);
+        if (!check(sample.timestamp > since, "sample at " + ofToString(sample.timestamp) + " ms is not after " + ofToString(since) + " ms") ||
+            !check(i == 0 || sample.timestamp >= samples[i - 1].timestamp, "samples out of order at " + ofToString(sample.timestamp) + " ms") ||
+            !check(glm::distance(sample.value, expected) < 1e-5f, "sample value at " + ofToString(sample.timestamp) + " ms"))
+        {
+            passed = false;
+            break;
+        }
+    }
+
+    // Between samples of both sensors, so both are interpolated.
+    const double timestamp = 501.3;
+    ofxRealSense2::ImuFrame frame;
+    passed &= check(history.interpolate(timestamp, frame), "no interpolated frame at " + ofToString(timestamp) + " ms");
+    passed &= check(glm::distance(frame.gyro, gyroAt(timestamp)) < 1e-4f, "interpolated gyro at " + ofToString(timestamp) + " ms");
+    passed &= check(glm::distance(frame.accel, accelAt(timestamp)) < 1e-4f, "interpolated accel at " + ofToString(timestamp) + " ms");
+
+    if (!passed) return 1;
+
+    ofLogNotice("imuTest") << "PASSED, " << history.size() << " samples";
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "ofMain.h"
+#include "ofxRealSense2.h"
+
+#include "../../common/TestDevice.h"
+
+#include <chrono>
+#include <ctime>
+
+// Compares what a depth frame costs when the app only reads the raw depth with
+// what it costs when it reads every derived output, which is what update() used
+// to compute for every frame. Main thread time covers update() and the getters,
+// process CPU time also covers the device thread.
+class ofApp
+    : public ofBaseApp
+{
+public:
+    enum Phase
+    {
+        RawDepth,
+        AllOutputs,
+        Done
+    };
+
+    struct Result
+    {
+        int numFrames;
+        double mainThreadMs;
+        std::clock_t cpuStart;
+        double cpuMs;
+    };
+
+    void setup() override
+    {
+        ofSetVerticalSync(false);
+        ofSetFrameRate(0);
+
+        auto nativeDevice = openTestDevice(this->context);
+        this->device = std::make_unique<ofxRealSense2::Device>(this->context, nativeDevice);
+        enableTestDepth(*this->device, nativeDevice);
+        this->device->enablePoints();
+        this->device->startPipeline();
+
+        this->phase = RawDepth;
+        this->lastFrameNumber = 0;
+        this->phaseFrames = 0;
+        this->results[RawDepth] = {};
+        this->results[AllOutputs] = {};
+    }
+
+    void update() override
+    {
+        if (this->phase == Done) return;
+
+        const auto startTime = std::chrono::steady_clock::now();
+
+        this->device->update();
+        const auto frameNumber = this->device->getDepthMetadata().frameNumber;
+        const bool newFrame = frameNumber != this->lastFrameNumber;
+        if (newFrame)
+        {
+            this->lastFrameNumber = frameNumber;
+            this->device->getRawDepthPix();
+            if (this->phase == AllOutputs)
+            {
+                this->device->getDepthPix();
+                this->device->getDepthTex();
+                this->device->getRawDepthTex();
+                this->device->getPointsMesh();
+            }
+        }
+
+        const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        if (!newFrame) return;
+
+        // The first frames of a phase warm up the buffers and the points demand.
+        ++this->phaseFrames;
+        auto & result = this->results[this->phase];
+        if (this->phaseFrames == WarmUpFrames)
+        {
+            result.cpuStart = std::clock();
+        }
+        if (this->phaseFrames <= WarmUpFrames) return;
+
+        ++result.numFrames;
+        result.mainThreadMs += elapsedMs;
+        if (result.numFrames == MeasuredFrames)
+        {
+            result.cpuMs = (std::clock() - result.cpuStart) * 1000.0 / CLOCKS_PER_SEC;
+            this->phase = (Phase)(this->phase + 1);
+            this->phaseFrames = 0;
+            if (this->phase == Done)
+            {
+                this->report();
+                ofExit();
+            }
+        }
+    }
+
+    void exit() override
+    {
+        this->device.reset();
+    }
+
+    void report()
+    {
+        const char * names[] = { "Raw depth only", "All outputs" };
+        for (int i = RawDepth; i < Done; ++i)
+        {
+            const auto & result = this->results[i];
+            ofLogNotice("lazyOutputsBenchmark") << names[i] << ": "
+                << ofToString(result.mainThreadMs / result.numFrames, 3) << " ms main thread, "
+                << ofToString(result.cpuMs / result.numFrames, 3) << " ms process CPU per frame";
+        }
+    }
+
+private:
+    static const int WarmUpFrames = 30;
+    static const int MeasuredFrames = 300;
+
+    rs2::context context;
+    std::unique_ptr<ofxRealSense2::Device> device;
+
+    Phase phase;
+    unsigned long long lastFrameNumber;
+    int phaseFrames;
+    Result results[Done];
+};
+
+int main()
+{
+    ofSetupOpenGL(640, 360, OF_WINDOW);
+    ofRunApp(new ofApp());
+}
\ No newline at end of file
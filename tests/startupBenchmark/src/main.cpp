@@ -0,0 +1,124 @@
+#include "ofMain.h"
+#include "ofxRealSense2.h"
+
+#include "../../common/TestDevice.h"
+
+#include <chrono>
+#include <thread>
+
+// Times cold starts, with the device cache disabled, against warm starts from a
+// cache saved by an earlier run, through the pipeline and with the sensors opened
+// directly. Start time covers startPipeline(), first frame time runs until the
+// first depth frame reaches update(). Set the log level to verbose to see which
+// path every start took.
+class ofApp
+    : public ofBaseApp
+{
+public:
+    struct Result
+    {
+        double startMs;
+        double firstFrameMs;
+        int numRuns;
+    };
+
+    void setup() override
+    {
+        auto nativeDevice = openTestDevice(this->context);
+
+        const auto cacheDirectory = ofxRealSense2::DeviceCache::getDirectory();
+
+        ofxRealSense2::DeviceCache::setDirectory("");
+        const auto cold = this->measure(nativeDevice, false);
+
+        // The first warm run saves the cache the others load.
+        ofxRealSense2::DeviceCache::setDirectory("startupBenchmark");
+        this->run(nativeDevice, false);
+        const auto warm = this->measure(nativeDevice, false);
+        const auto warmDirect = this->measure(nativeDevice, true);
+
+        ofxRealSense2::DeviceCache::setDirectory(cacheDirectory);
+
+        this->report("Cold", cold);
+        this->report("Warm", warm);
+        this->report("Warm direct", warmDirect);
+        ofExit();
+    }
+
+    Result measure(const rs2::device & nativeDevice, bool directStart)
+    {
+        Result result = {};
+        for (int i = 0; i < NumRuns; ++i)
+        {
+            const auto run = this->run(nativeDevice, directStart);
+            if (run.numRuns == 0) continue;
+
+            result.startMs += run.startMs;
+            result.firstFrameMs += run.firstFrameMs;
+            ++result.numRuns;
+        }
+        return result;
+    }
+
+    Result run(const rs2::device & nativeDevice, bool directStart)
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        auto device = std::make_unique<ofxRealSense2::Device>(this->context, nativeDevice);
+        enableTestDepth(*device, nativeDevice);
+        if (directStart)
+        {
+            device->enableDirectStart();
+        }
+
+        const auto startTime = Clock::now();
+        device->startPipeline();
+        const auto startedTime = Clock::now();
+
+        Result result = {};
+        while (Clock::now() - startTime < std::chrono::seconds(5))
+        {
+            device->update();
+            if (device->getDepthMetadata().valid)
+            {
+                result.startMs = std::chrono::duration<double, std::milli>(startedTime - startTime).count();
+                result.firstFrameMs = std::chrono::duration<double, std::milli>(Clock::now() - startTime).count();
+                result.numRuns = 1;
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (result.numRuns == 0)
+        {
+            ofLogWarning("startupBenchmark") << "No depth frame within 5 s, run skipped";
+        }
+
+        device->stopPipeline();
+        return result;
+    }
+
+    void report(const std::string & name, const Result & result)
+    {
+        if (result.numRuns == 0)
+        {
+            ofLogError("startupBenchmark") << name << ": no successful runs";
+            return;
+        }
+
+        ofLogNotice("startupBenchmark") << name << ": "
+            << ofToString(result.startMs / result.numRuns, 1) << " ms to start, "
+            << ofToString(result.firstFrameMs / result.numRuns, 1) << " ms to the first frame, "
+            << result.numRuns << " runs";
+    }
+
+private:
+    static const int NumRuns = 10;
+
+    rs2::context context;
+};
+
+int main()
+{
+    ofSetupOpenGL(320, 240, OF_WINDOW);
+    ofRunApp(new ofApp());
+}
\ No newline at end of file